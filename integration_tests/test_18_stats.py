@@ -0,0 +1,94 @@
+import pytest
+from client_helper import IRCClient
+from conftest import SERVER_PORT, SERVER_PASSWORD
+
+# STATS の応答として想定するニューメリック
+ERR_UNKNOWNCOMMAND = "421"
+ERR_NOPRIVILEGES = "481"
+RPL_ENDOFSTATS = "219"
+
+
+def wait_for_any(client, commands, timeout=2.0):
+    """
+    commands のいずれかを受信するまで待機し、最初に一致したメッセージを返す。
+    """
+    msg = client.get_message(timeout=timeout)
+    while msg is not None:
+        if msg["command"] in commands:
+            return msg
+        msg = client.get_message(timeout=timeout)
+    return None
+
+
+def send_stats(client, query):
+    """
+    STATS を送信し、最初の応答を返す。
+    サーバーが STATS を実装していない (421) 場合はテストをスキップする。
+    """
+    client.send(f"STATS {query}")
+    msg = wait_for_any(client, [ERR_UNKNOWNCOMMAND, ERR_NOPRIVILEGES, RPL_ENDOFSTATS])
+    assert msg is not None, f"No reply to STATS {query}"
+    if msg["command"] == ERR_UNKNOWNCOMMAND:
+        pytest.skip("STATS is not implemented by this ircserv build")
+    return msg
+
+
+def test_stats_commands_requires_operator(irc_server):
+    """
+    Tests that the per-command latency report (STATS m) is operator-only.
+    A regular user must get ERR_NOPRIVILEGES (481) and no statistics.
+    """
+    client = IRCClient(SERVER_PORT, "statuser")
+    client.connect()
+    client.register(SERVER_PASSWORD)
+
+    # 統計を貯めるために何かコマンドを実行しておく
+    client.send("PING :warmup")
+    assert client.wait_for_command("PONG") is not None
+
+    msg = send_stats(client, "m")
+    assert msg["command"] == ERR_NOPRIVILEGES, \
+        f"Regular user should get 481 for STATS m, got {msg['command']}"
+
+    client.close()
+
+
+def test_stats_reset_requires_operator(irc_server):
+    """
+    Tests that resetting the per-command histograms (STATS m reset)
+    is also refused for a regular user.
+    """
+    client = IRCClient(SERVER_PORT, "statreset")
+    client.connect()
+    client.register(SERVER_PASSWORD)
+
+    msg = send_stats(client, "m reset")
+    assert msg["command"] == ERR_NOPRIVILEGES, \
+        f"Regular user should get 481 for STATS m reset, got {msg['command']}"
+
+    client.close()
+
+
+def test_stats_links_requires_operator(irc_server):
+    """
+    Tests that the per-connection traffic report (STATS l) is operator-only,
+    even when other clients have queued traffic to report on.
+    """
+    sender = IRCClient(SERVER_PORT, "statsend")
+    receiver = IRCClient(SERVER_PORT, "statrecv")
+    sender.connect()
+    receiver.connect()
+    sender.register(SERVER_PASSWORD)
+    receiver.register(SERVER_PASSWORD)
+
+    # 送受信カウンタが動くように少しトラフィックを流す
+    for i in range(10):
+        sender.send(f"PRIVMSG statrecv :traffic_{i}")
+    assert receiver.wait_for_command("PRIVMSG") is not None
+
+    msg = send_stats(sender, "l")
+    assert msg["command"] == ERR_NOPRIVILEGES, \
+        f"Regular user should get 481 for STATS l, got {msg['command']}"
+
+    sender.close()
+    receiver.close()
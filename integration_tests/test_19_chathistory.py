@@ -0,0 +1,160 @@
+import time
+from datetime import datetime, timezone
+
+import pytest
+from client_helper import IRCClient
+from conftest import SERVER_PORT, SERVER_PASSWORD
+
+ERR_UNKNOWNCOMMAND = "421"
+CHANNEL = "#history"
+
+
+def join_channel(client, channel=CHANNEL):
+    client.send(f"JOIN {channel}")
+    assert client.wait_for_command("JOIN") is not None, f"{client.nick} could not join {channel}"
+    # NAMES などの JOIN 後の応答を読み捨てる
+    while client.get_message(timeout=0.3) is not None:
+        pass
+
+
+def sync(client):
+    """PING で同期し、それまでに送ったメッセージがサーバーで処理されたことを確かめる。"""
+    client.send("PING :sync")
+    assert client.wait_for_command("PONG") is not None
+
+
+def history_timestamp():
+    """現在時刻を CHATHISTORY の timestamp= 形式 (UTC, ミリ秒) で返す。"""
+    now = datetime.now(timezone.utc)
+    return now.strftime("%Y-%m-%dT%H:%M:%S.") + f"{now.microsecond // 1000:03d}Z"
+
+
+def request_history(client, subcommand, count, timeout=3.0):
+    """
+    CHATHISTORY を送信し、再送された PRIVMSG / NOTICE を count 件まで集めて返す。
+    サーバーが CHATHISTORY を実装していない (421) 場合はテストをスキップする。
+    batch を要求していないため、再送は通常のメッセージとして届く。
+    """
+    client.send(f"CHATHISTORY {subcommand}")
+    replayed = []
+    deadline = time.time() + timeout
+    while len(replayed) < count and time.time() < deadline:
+        msg = client.get_message(timeout=0.5)
+        if msg is None:
+            continue
+        if msg["command"] == ERR_UNKNOWNCOMMAND:
+            pytest.skip("CHATHISTORY is not implemented by this ircserv build")
+        assert msg["command"] != "FAIL", f"CHATHISTORY {subcommand} failed: {msg}"
+        if msg["command"] in ("PRIVMSG", "NOTICE") and msg["args"][0] == CHANNEL:
+            replayed.append(msg)
+    return replayed
+
+
+def send_batches(client, prefix):
+    """
+    3件ずつ2回に分けてメッセージを送り、その間の時刻を返す。
+    サーバーの時刻がミリ秒単位で丸められても境界をまたがないよう、前後に間を空ける。
+    """
+    for i in range(3):
+        client.send(f"PRIVMSG {CHANNEL} :{prefix}_early_{i}")
+    sync(client)
+    time.sleep(0.05)
+    middle = history_timestamp()
+    time.sleep(0.05)
+    for i in range(3):
+        client.send(f"PRIVMSG {CHANNEL} :{prefix}_late_{i}")
+    sync(client)
+    return middle
+
+
+def test_chathistory_latest_returns_recent_messages(irc_server):
+    """
+    Tests that CHATHISTORY LATEST replays the newest channel messages
+    to a client that joined after they were sent, oldest first.
+    """
+    alice = IRCClient(SERVER_PORT, "histalice")
+    alice.connect()
+    alice.register(SERVER_PASSWORD)
+    join_channel(alice)
+
+    for i in range(5):
+        alice.send(f"PRIVMSG {CHANNEL} :history_{i}")
+    # 送信したメッセージが履歴に入るのを待つ (自分宛てには届かないので PING で同期する)
+    sync(alice)
+
+    bob = IRCClient(SERVER_PORT, "histbob")
+    bob.connect()
+    bob.register(SERVER_PASSWORD)
+    join_channel(bob)
+
+    replayed = request_history(bob, f"LATEST {CHANNEL} * 3", 3)
+    texts = [msg["args"][1] for msg in replayed]
+    assert texts == ["history_2", "history_3", "history_4"], \
+        f"Expected the 3 latest messages in order, got {texts}"
+    assert all(msg["prefix"].get("nick") == "histalice" for msg in replayed), \
+        "Replayed messages should keep the original sender prefix"
+
+    alice.close()
+    bob.close()
+
+
+def test_chathistory_includes_notice(irc_server):
+    """
+    Tests that channel NOTICEs are kept in the history alongside PRIVMSGs.
+    """
+    alice = IRCClient(SERVER_PORT, "notealice")
+    alice.connect()
+    alice.register(SERVER_PASSWORD)
+    join_channel(alice)
+
+    alice.send(f"PRIVMSG {CHANNEL} :before_notice")
+    alice.send(f"NOTICE {CHANNEL} :notice_text")
+    sync(alice)
+
+    replayed = request_history(alice, f"LATEST {CHANNEL} * 2", 2)
+    assert [(msg["command"], msg["args"][1]) for msg in replayed] == [
+        ("PRIVMSG", "before_notice"), ("NOTICE", "notice_text")], \
+        f"Expected PRIVMSG then NOTICE in history, got {replayed}"
+
+    alice.close()
+
+
+def test_chathistory_before_timestamp(irc_server):
+    """
+    Tests that CHATHISTORY BEFORE returns only the messages sent
+    before the given timestamp, oldest first.
+    """
+    alice = IRCClient(SERVER_PORT, "beforealice")
+    alice.connect()
+    alice.register(SERVER_PASSWORD)
+    join_channel(alice)
+
+    middle = send_batches(alice, "before")
+
+    # 上限を件数より大きくし、境界より後のメッセージが混ざらないことも確かめる
+    replayed = request_history(alice, f"BEFORE {CHANNEL} timestamp={middle} 10", 4, timeout=2.0)
+    texts = [msg["args"][1] for msg in replayed]
+    assert texts == ["before_early_0", "before_early_1", "before_early_2"], \
+        f"Expected only the messages before {middle}, got {texts}"
+
+    alice.close()
+
+
+def test_chathistory_after_timestamp(irc_server):
+    """
+    Tests that CHATHISTORY AFTER returns only the messages sent
+    after the given timestamp, oldest first.
+    """
+    alice = IRCClient(SERVER_PORT, "afteralice")
+    alice.connect()
+    alice.register(SERVER_PASSWORD)
+    join_channel(alice)
+
+    middle = send_batches(alice, "after")
+
+    replayed = request_history(alice, f"AFTER {CHANNEL} timestamp={middle} 10", 4, timeout=2.0)
+    texts = [msg["args"][1] for msg in replayed]
+    assert texts == ["after_late_0", "after_late_1", "after_late_2"], \
+        f"Expected only the messages after {middle}, got {texts}"
+
+    alice.close()
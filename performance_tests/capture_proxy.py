@@ -0,0 +1,92 @@
+"""
+クライアントとサーバーの間に入る記録用の TCP プロキシ。
+クライアントが送った行を接続ごとに時刻付きで .irccap ファイルに記録し、そのままサーバーへ中継する。
+サーバーからの行は中継しつつ数だけを記録する (irc_replay が応答数のずれを比べるのに使う)。
+
+    python3 capture_proxy.py --listen-port 6670 --output capture.irccap
+    # クライアントは 6670 に接続する。Ctrl-C で記録を終了する
+    ./loadgen/irc_replay --file capture.irccap --port 6669 --mode max
+"""
+import argparse
+import asyncio
+import signal
+
+from server_runner import SERVER_HOST, SERVER_PORT
+from trafficlog import CLOSE, LINE, OPEN, REPLY, TrafficWriter
+
+
+class CaptureProxy:
+    def __init__(self, args, writer):
+        self.args = args
+        self.writer = writer
+        self.next_session = 0
+        self.lines = 0
+
+    async def handle(self, client_reader, client_writer):
+        try:
+            server_reader, server_writer = await asyncio.open_connection(
+                self.args.server_host, self.args.server_port)
+        except OSError as e:
+            print(f"{client_writer.get_extra_info('peername')}: cannot connect to the server: {e}")
+            client_writer.close()
+            return
+        # 番号はサーバーに繋がった接続にだけ振り、キャプチャ内のセッション番号を連番に保つ
+        session = self.next_session
+        self.next_session += 1
+        self.writer.write(OPEN, session)
+        upstream = asyncio.ensure_future(
+            self.pump(client_reader, server_writer, session, LINE))
+        downstream = asyncio.ensure_future(
+            self.pump(server_reader, client_writer, session, REPLY))
+        # どちらかが閉じたら、もう一方も閉じる
+        await asyncio.wait([upstream, downstream], return_when=asyncio.FIRST_COMPLETED)
+        for task in (upstream, downstream):
+            task.cancel()
+        for writer in (client_writer, server_writer):
+            writer.close()
+        self.writer.write(CLOSE, session)
+
+    async def pump(self, reader, writer, session, record_type):
+        """reader から1行ずつ読んで記録し、writer へ中継する。"""
+        while True:
+            line = await reader.readline()
+            if not line:
+                return
+            if record_type == LINE:
+                self.writer.write(LINE, session, line.rstrip(b"\r\n"))
+                self.lines += 1
+            else:
+                self.writer.write(REPLY, session)
+            writer.write(line)
+            await writer.drain()
+
+
+async def serve(args):
+    writer = TrafficWriter(args.output)
+    proxy = CaptureProxy(args, writer)
+    server = await asyncio.start_server(proxy.handle, args.listen_host, args.listen_port,
+                                        limit=64 * 1024)
+    print(f"Capturing {args.listen_host}:{args.listen_port} -> "
+          f"{args.server_host}:{args.server_port} into {args.output} (Ctrl-C to stop)")
+    stop = asyncio.Event()
+    loop = asyncio.get_running_loop()
+    for sig in (signal.SIGINT, signal.SIGTERM):
+        loop.add_signal_handler(sig, stop.set)
+    async with server:
+        await stop.wait()
+    writer.close()
+    print(f"Saved {args.output}: {proxy.next_session} sessions, {proxy.lines} lines")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Record IRC client traffic for irc_replay")
+    parser.add_argument("--listen-host", default="127.0.0.1")
+    parser.add_argument("--listen-port", type=int, default=6670)
+    parser.add_argument("--server-host", default=SERVER_HOST)
+    parser.add_argument("--server-port", type=int, default=SERVER_PORT)
+    parser.add_argument("--output", default="capture.irccap")
+    asyncio.run(serve(parser.parse_args()))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,128 @@
+"""
+接続 -> 登録 -> JOIN -> QUIT を繰り返すクライアントでサーバーを長時間叩き、
+持続できるサイクル数/秒、各段階のテールレイテンシ、実行前後の fd 数と RSS を測るベンチマーク。
+切断処理で fd やメモリが漏れていれば、実行後の fd 数と RSS の増加として現れる。
+
+    python3 churn_bench.py --clients 200 --duration 300
+"""
+import argparse
+import json
+import os
+import tempfile
+import threading
+import time
+
+from server_runner import (IRCServerProcess, SERVER_EXECUTABLE, SERVER_PASSWORD, SERVER_PORT,
+                           raise_fd_limit, run_loadgen)
+
+
+def sample_rss(server, interval, samples, stop):
+    """stop がセットされるまで interval 秒ごとにサーバーの RSS を記録する。"""
+    start = time.monotonic()
+    while not stop.wait(interval):
+        samples.append({"t": round(time.monotonic() - start, 1), "rss_kb": server.rss_kb()})
+
+
+def snapshot(server):
+    """サーバーの fd 数とメモリ使用量を1回分読む。"""
+    return {
+        "fds": server.fd_count(),
+        "rss_kb": server.rss_kb(),
+        "anonymous_kb": server.smaps_rollup().get("Anonymous", -1),
+    }
+
+
+def run(args):
+    with tempfile.TemporaryDirectory() as tmp:
+        json_path = os.path.join(tmp, "churn.json")
+        with IRCServerProcess(args.server, args.port, args.password) as server:
+            before = snapshot(server)
+            samples = []
+            stop = threading.Event()
+            sampler = threading.Thread(target=sample_rss,
+                                       args=(server, args.sample_interval, samples, stop))
+            sampler.start()
+            try:
+                report = run_loadgen([
+                    "--scenario", "churn",
+                    "--port", args.port,
+                    "--password", args.password,
+                    "--clients", args.clients,
+                    "--threads", args.threads,
+                    "--channels", args.channels,
+                    "--joins", args.joins,
+                    "--connect-rate", args.clients * 10,
+                    "--duration", args.duration,
+                    "--source-addrs", args.source_addrs,
+                    "--server-pid", server.pid,
+                    "--quiet",
+                ], json_path)
+            finally:
+                stop.set()
+                sampler.join()
+            # 最後の切断がサーバー側で処理されるのを待ってから数える
+            time.sleep(args.settle)
+            after = snapshot(server)
+    report["server_before"] = before
+    report["server_after"] = after
+    report["rss_samples"] = samples
+    report["leaked_fds"] = after["fds"] - before["fds"]
+    report["rss_growth_kb"] = after["rss_kb"] - before["rss_kb"]
+    return report
+
+
+def print_summary(report):
+    counters = report.get("counters", {})
+    rates = report.get("throughput", {})
+    latency = report.get("latency_us", {})
+    print("\n=== connection churn ===")
+    print(f"cycles        : {counters.get('cycles', 0)} "
+          f"({rates.get('cycles_per_s', 0):.1f}/s)")
+    print(f"errors        : connect {counters.get('connect_errors', 0)}, "
+          f"register {counters.get('register_errors', 0)}, "
+          f"join {counters.get('join_errors', 0)}, "
+          f"setup timeouts {counters.get('setup_timeouts', 0)}, "
+          f"quit timeouts {counters.get('quit_timeouts', 0)}, "
+          f"disconnects {counters.get('disconnects', 0)}")
+    print(f"{'phase':<10} {'p50 us':>10} {'p99 us':>10} {'p99.9 us':>10} {'max us':>10}")
+    for phase in ("connect", "register", "join", "quit", "cycle"):
+        h = latency.get(phase, {})
+        print(f"{phase:<10} {h.get('p50', 0):>10.0f} {h.get('p99', 0):>10.0f} "
+              f"{h.get('p999', 0):>10.0f} {h.get('max', 0):>10.0f}")
+    before, after = report["server_before"], report["server_after"]
+    print(f"server fds    : {before['fds']} -> {after['fds']} (leaked {report['leaked_fds']})")
+    print(f"server RSS    : {before['rss_kb']} kB -> {after['rss_kb']} kB "
+          f"(+{report['rss_growth_kb']} kB)")
+    print(f"server cpu    : {report.get('server_cpu_percent', -1):.1f} %")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Connection churn benchmark")
+    parser.add_argument("--clients", type=int, default=200,
+                        help="number of concurrent connect/quit loops")
+    parser.add_argument("--duration", type=float, default=300.0)
+    parser.add_argument("--channels", type=int, default=10)
+    parser.add_argument("--joins", type=int, default=1)
+    parser.add_argument("--threads", type=int, default=os.cpu_count() or 4)
+    parser.add_argument("--source-addrs", type=int, default=4,
+                        help="spread source ports over 127.0.0.x to avoid TIME_WAIT exhaustion")
+    parser.add_argument("--sample-interval", type=float, default=5.0)
+    parser.add_argument("--settle", type=float, default=1.0)
+    parser.add_argument("--server", default=SERVER_EXECUTABLE)
+    parser.add_argument("--port", type=int, default=SERVER_PORT)
+    parser.add_argument("--password", default=SERVER_PASSWORD)
+    parser.add_argument("--output", default="churn_result.json")
+    args = parser.parse_args()
+
+    raise_fd_limit()
+    report = run(args)
+    print_summary(report)
+    with open(args.output, "w") as f:
+        json.dump({"benchmark": "churn", "result": report}, f, indent=2)
+    print(f"Saved {args.output}")
+    if report["leaked_fds"] > 0:
+        print(f"WARNING: server holds {report['leaked_fds']} more fds than before the run")
+
+
+if __name__ == "__main__":
+    main()
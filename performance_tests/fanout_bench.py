@@ -0,0 +1,114 @@
+"""
+1チャンネルに N 人の待ち受けクライアントを集め、1人の送信者の PRIVMSG が
+全員に届くまでのレイテンシとサーバーの CPU 使用率を測るベンチマーク。
+
+    python3 fanout_bench.py --sizes 100,1000,5000,10000,50000 --publish-rate 10
+"""
+import argparse
+import json
+import os
+import tempfile
+
+from server_runner import (IRCServerProcess, SERVER_EXECUTABLE, SERVER_PASSWORD, SERVER_PORT,
+                           raise_fd_limit, run_loadgen, source_addrs_for)
+
+# 準備中にサーバーが配送できる JOIN 通知の数 (行/秒) の控えめな見積もり
+JOIN_NOTICES_PER_SEC = 1000000
+
+
+def setup_timeout(clients, connect_rate):
+    """
+    JOIN 通知は参加済みの全員に届くため、全員の JOIN で約 N^2 / 2 行が配送される。
+    最後のクライアントの JOIN はそれを待つので、準備の制限時間も N に対して二次で増やす。
+    """
+    notices = clients * clients / 2
+    return int(60 + clients / connect_rate + notices / JOIN_NOTICES_PER_SEC)
+
+
+def fully_joined(report, clients):
+    """全員が登録・JOIN を終えた状態で計測できたか。"""
+    counters = report.get("counters", {})
+    return (counters.get("registered", 0) >= clients and counters.get("connect_errors", 0) == 0
+            and counters.get("setup_timeouts", 0) == 0 and counters.get("join_errors", 0) == 0)
+
+
+def run_step(args, clients):
+    """N = clients の1ステップ分: サーバーを起動し直して fanout シナリオを実行する。"""
+    with tempfile.TemporaryDirectory() as tmp:
+        json_path = os.path.join(tmp, "fanout.json")
+        with IRCServerProcess(args.server, args.port, args.password) as server:
+            report = run_loadgen([
+                "--scenario", "fanout",
+                "--port", args.port,
+                "--password", args.password,
+                "--clients", clients,
+                "--threads", args.threads,
+                "--connect-rate", args.connect_rate,
+                "--setup-timeout", setup_timeout(clients, args.connect_rate),
+                "--publish-rate", args.publish_rate,
+                "--payload", args.payload,
+                "--duration", args.duration,
+                "--source-addrs", source_addrs_for(clients),
+                "--server-pid", server.pid,
+                "--quiet",
+            ], json_path)
+            report["server_rss_kb"] = server.rss_kb()
+    # 一部しか参加していないチャンネルの計測値は N 人分のファンアウトではないので使わない
+    report["complete_setup"] = fully_joined(report, clients)
+    if not report["complete_setup"]:
+        print(f"WARNING: {clients} members: not every client joined before the measurement "
+              f"({report.get('counters', {})}), excluding this step")
+    return report
+
+
+def print_table(results):
+    print("\n=== channel fan-out ===")
+    print(f"{'members':>8} {'msgs':>6} {'complete':>9} "
+          f"{'first p50':>10} {'first p99':>10} {'med p50':>10} {'med p99':>10} "
+          f"{'last p50':>10} {'last p99':>10} {'cpu %':>7}")
+    for r in results:
+        if not r.get("complete_setup", True):
+            print(f"{r['config']['clients']:>8}  incomplete setup, not measured")
+            continue
+        fanout = r.get("fanout", {})
+        messages = fanout.get("messages", 0)
+        complete = 100.0 * fanout.get("complete", 0) / messages if messages else 0.0
+        row = [fanout.get(k, {}) for k in ("first", "median", "last")]
+        latencies = " ".join(f"{h.get('p50', 0):10.0f} {h.get('p99', 0):10.0f}" for h in row)
+        print(f"{r['config']['clients']:>8} {messages:>6} {complete:>8.1f}% {latencies} "
+              f"{r.get('server_cpu_percent', -1):>7.1f}")
+    print("(latency in microseconds)")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Channel fan-out latency benchmark")
+    parser.add_argument("--sizes", default="100,1000,5000,10000,50000",
+                        help="comma separated channel member counts")
+    parser.add_argument("--publish-rate", type=float, default=10.0)
+    parser.add_argument("--duration", type=float, default=10.0)
+    parser.add_argument("--payload", type=int, default=64)
+    parser.add_argument("--threads", type=int, default=os.cpu_count() or 4)
+    parser.add_argument("--connect-rate", type=float, default=2000.0)
+    parser.add_argument("--server", default=SERVER_EXECUTABLE)
+    parser.add_argument("--port", type=int, default=SERVER_PORT)
+    parser.add_argument("--password", default=SERVER_PASSWORD)
+    parser.add_argument("--output", default="fanout_result.json")
+    args = parser.parse_args()
+
+    limit = raise_fd_limit()
+    sizes = [int(size) for size in args.sizes.split(",") if size]
+    results = []
+    for clients in sizes:
+        if clients + 64 > limit:
+            print(f"Skipping {clients} members: fd limit is {limit} (raise it with ulimit -n)")
+            continue
+        results.append(run_step(args, clients))
+
+    print_table(results)
+    with open(args.output, "w") as f:
+        json.dump({"benchmark": "fanout", "results": results}, f, indent=2)
+    print(f"Saved {args.output}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,103 @@
+#include "Capture.hpp"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+
+namespace {
+
+const char kMagic[] = "IRCCAP01";
+const size_t kMagicSize = sizeof(kMagic) - 1;
+
+enum RecordType { RECORD_OPEN = 1, RECORD_LINE = 2, RECORD_REPLY = 3, RECORD_CLOSE = 4 };
+
+// LEB128 の可変長整数を読む。データが途中で切れていたら false
+bool readVarint(const std::string &data, size_t &pos, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; pos < data.size() && shift < 64; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(data[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string toString(uint64_t value) {
+    std::ostringstream oss;
+    oss << value;
+    return oss.str();
+}
+
+} // namespace
+
+bool loadCapture(const std::string &path, std::vector<CapturedSession> &sessions,
+                 std::string &error) {
+    std::ifstream ifs(path.c_str(), std::ios::binary);
+    if (!ifs) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    if (data.size() < kMagicSize || data.compare(0, kMagicSize, kMagic) != 0) {
+        error = path + ": not an irccap file";
+        return false;
+    }
+
+    size_t pos = kMagicSize;
+    uint64_t now = 0;
+    // セッション番号 -> sessions の位置。セッションは OPEN レコードでだけ作るため、
+    // 壊れたファイルの巨大な番号でメモリを確保しきることはない
+    std::map<uint64_t, size_t> index;
+    while (pos < data.size()) {
+        int type = static_cast<uint8_t>(data[pos++]);
+        uint64_t session = 0;
+        uint64_t delta = 0;
+        if (!readVarint(data, pos, session) || !readVarint(data, pos, delta)) {
+            error = path + ": truncated record";
+            return false;
+        }
+        now += delta;
+        if (type == RECORD_OPEN) {
+            if (!index.insert(std::make_pair(session, sessions.size())).second) {
+                error = path + ": duplicate OPEN record for session " + toString(session);
+                return false;
+            }
+            sessions.push_back(CapturedSession());
+            sessions.back().id = session;
+            sessions.back().openAt = now;
+            continue;
+        }
+        std::map<uint64_t, size_t>::const_iterator found = index.find(session);
+        if (found == index.end()) {
+            error = path + ": record for session " + toString(session) + " before its OPEN";
+            return false;
+        }
+        CapturedSession &s = sessions[found->second];
+        switch (type) {
+        case RECORD_LINE: {
+            uint64_t length = 0;
+            if (!readVarint(data, pos, length) || length > data.size() - pos) {
+                error = path + ": truncated line";
+                return false;
+            }
+            s.lineAt.push_back(now);
+            s.lines.push_back(data.substr(pos, length));
+            pos += length;
+            break;
+        }
+        case RECORD_REPLY:
+            ++s.replies;
+            break;
+        case RECORD_CLOSE:
+            s.closeAt = now;
+            break;
+        default:
+            error = path + ": unknown record type";
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+#ifndef CAPTURE_HPP
+#define CAPTURE_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief capture_proxy.py が書いた .irccap ファイルの1接続分
+ *
+ * フォーマットは performance_tests/trafficlog.py を参照。
+ * 時刻はすべてキャプチャ開始からのマイクロ秒。
+ */
+struct CapturedSession {
+    uint64_t id;                    // キャプチャ内のセッション番号 (sessions の位置とは限らない)
+    uint64_t openAt;
+    uint64_t closeAt;
+    std::vector<uint64_t> lineAt;   // lines[i] を送った時刻
+    std::vector<std::string> lines; // クライアント -> サーバーの行 (CRLF なし)
+    uint64_t replies;               // キャプチャ時にサーバーから届いた行数
+
+    CapturedSession() : id(0), openAt(0), closeAt(0), replies(0) {}
+};
+
+// path を読み、OPEN レコードの順に sessions へ入れる (番号が飛んでいても詰めて入れる)。
+// 壊れたファイルなら error を設定して false を返す
+bool loadCapture(const std::string &path, std::vector<CapturedSession> &sessions,
+                 std::string &error);
+
+#endif
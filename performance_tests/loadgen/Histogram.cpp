@@ -0,0 +1,76 @@
+#include "Histogram.hpp"
+#include <cstddef>
+
+Histogram::Histogram()
+    : _buckets((64 - kSubBucketBits + 1) * kSubBuckets, 0), _count(0), _min(UINT64_MAX), _max(0),
+      _sum(0) {}
+
+int Histogram::bucketIndex(uint64_t value) {
+    if (value < static_cast<uint64_t>(kSubBuckets)) {
+        return static_cast<int>(value);
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    int shift = exponent - kSubBucketBits;
+    int sub = static_cast<int>((value >> shift) & (kSubBuckets - 1));
+    return (shift + 1) * kSubBuckets + sub;
+}
+
+uint64_t Histogram::bucketValue(int index) {
+    if (index < kSubBuckets) {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = index / kSubBuckets - 1;
+    uint64_t sub = static_cast<uint64_t>(index % kSubBuckets);
+    return (static_cast<uint64_t>(kSubBuckets) + sub) << shift;
+}
+
+void Histogram::record(uint64_t value) {
+    ++_buckets[bucketIndex(value)];
+    ++_count;
+    _sum += static_cast<double>(value);
+    if (value < _min) {
+        _min = value;
+    }
+    if (value > _max) {
+        _max = value;
+    }
+}
+
+void Histogram::merge(const Histogram &other) {
+    for (std::size_t i = 0; i < _buckets.size(); ++i) {
+        _buckets[i] += other._buckets[i];
+    }
+    _count += other._count;
+    _sum += other._sum;
+    if (other._count && other._min < _min) {
+        _min = other._min;
+    }
+    if (other._max > _max) {
+        _max = other._max;
+    }
+}
+
+double Histogram::mean() const { return _count ? _sum / static_cast<double>(_count) : 0.0; }
+
+// p は 0.0 - 100.0。バケットの下限値を返す (最大値は超えない)
+uint64_t Histogram::percentile(double p) const {
+    if (_count == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(_count) + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < _buckets.size(); ++i) {
+        seen += _buckets[i];
+        if (seen >= rank) {
+            uint64_t value = bucketValue(static_cast<int>(i));
+            if (value < min()) {
+                return min();
+            }
+            return value < _max ? value : _max;
+        }
+    }
+    return _max;
+}
@@ -0,0 +1,40 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief 対数バケットのレイテンシヒストグラム (HDR 風、相対誤差は約3%)
+ *
+ * 記録はバケットの加算のみなのでワーカースレッドごとに持ち、
+ * 終了時に merge() で集計する。
+ */
+class Histogram {
+  public:
+    Histogram();
+
+    void record(uint64_t value);
+    void merge(const Histogram &other);
+
+    uint64_t count() const { return _count; }
+    uint64_t min() const { return _count ? _min : 0; }
+    uint64_t max() const { return _max; }
+    double mean() const;
+    uint64_t percentile(double p) const;
+
+  private:
+    static const int kSubBucketBits = 5;
+    static const int kSubBuckets = 1 << kSubBucketBits;
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketValue(int index);
+
+    std::vector<uint64_t> _buckets;
+    uint64_t _count;
+    uint64_t _min;
+    uint64_t _max;
+    double _sum;
+};
+
+#endif
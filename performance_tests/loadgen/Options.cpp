@@ -0,0 +1,140 @@
+#include "Options.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+Options::Options()
+    : scenario("load"), host("127.0.0.1"), port(6667), password("testpass"), sourceAddresses(1),
+      serverPid(0), clients(100), threads(4), connectRate(500.0), setupTimeout(30.0), channels(10),
+      channelPrefix("lg"), joinsPerClient(1), messageRate(1.0), payloadSize(64), duration(30.0), publishRate(10.0),
+      nickPrefix("lg"), quiet(false), hold(false) {}
+
+static void printUsage(const char *program) {
+    Options d;
+    std::cerr
+        << "Usage: " << program << " [options]\n"
+        << "  --scenario NAME      load | fanout | churn (" << d.scenario << ")\n"
+        << "                       fanout: every client joins #fanout, client 0 publishes\n"
+        << "                       churn: each client loops connect/register/JOIN/QUIT\n"
+        << "  --host HOST          server address (" << d.host << ")\n"
+        << "  --port PORT          server port (" << d.port << ")\n"
+        << "  --password PASS      connection password sent with PASS (" << d.password << ")\n"
+        << "  --source-addrs N     bind sources 127.0.0.1..N to get past the ephemeral port\n"
+        << "                       limit of a single address (" << d.sourceAddresses << ")\n"
+        << "  --server-pid PID     report the server's CPU usage while measuring\n"
+        << "  --clients N          total connections (" << d.clients << ")\n"
+        << "  --threads N          epoll worker threads (" << d.threads << ")\n"
+        << "  --connect-rate R     new connections per second, 0 = unlimited ("
+        << d.connectRate << ")\n"
+        << "  --setup-timeout S    seconds allowed for register + JOIN (" << d.setupTimeout
+        << ")\n"
+        << "  --channels N         number of channels #P0..#PN-1 (" << d.channels << ")\n"
+        << "  --channel-prefix P   channel name prefix, channel = #P + index ("
+        << d.channelPrefix << ")\n"
+        << "  --joins N            channels joined by each client (" << d.joinsPerClient << ")\n"
+        << "  --msg-rate R         PRIVMSG per client per second, 0 = idle (" << d.messageRate
+        << ")\n"
+        << "  --payload BYTES      PRIVMSG text size (" << d.payloadSize << ")\n"
+        << "  --duration S         measured messaging time in seconds (" << d.duration << ")\n"
+        << "  --publish-rate R     fanout: PRIVMSG per second from the publisher ("
+        << d.publishRate << ")\n"
+        << "  --nick-prefix P      nickname prefix, nick = P + index (" << d.nickPrefix << ")\n"
+        << "  --json PATH          write the report as JSON\n"
+        << "  --quiet              no per-second progress lines\n"
+        << "  --hold               after setup print \"ready <active>/<clients>\" and keep every\n"
+        << "                       connection idle until stdin is closed (used by memory_bench.py)\n";
+}
+
+bool parseOptions(int argc, char **argv, Options &o) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return false;
+        }
+        if (arg == "--quiet") {
+            o.quiet = true;
+            continue;
+        }
+        if (arg == "--hold") {
+            o.hold = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+        const char *value = argv[++i];
+        if (arg == "--scenario") {
+            o.scenario = value;
+        } else if (arg == "--host") {
+            o.host = value;
+        } else if (arg == "--port") {
+            o.port = std::atoi(value);
+        } else if (arg == "--password") {
+            o.password = value;
+        } else if (arg == "--source-addrs") {
+            o.sourceAddresses = std::atoi(value);
+        } else if (arg == "--server-pid") {
+            o.serverPid = std::atoi(value);
+        } else if (arg == "--clients") {
+            o.clients = std::atoi(value);
+        } else if (arg == "--threads") {
+            o.threads = std::atoi(value);
+        } else if (arg == "--connect-rate") {
+            o.connectRate = std::atof(value);
+        } else if (arg == "--setup-timeout") {
+            o.setupTimeout = std::atof(value);
+        } else if (arg == "--channels") {
+            o.channels = std::atoi(value);
+        } else if (arg == "--channel-prefix") {
+            o.channelPrefix = value;
+        } else if (arg == "--joins") {
+            o.joinsPerClient = std::atoi(value);
+        } else if (arg == "--msg-rate") {
+            o.messageRate = std::atof(value);
+        } else if (arg == "--payload") {
+            o.payloadSize = std::atoi(value);
+        } else if (arg == "--duration") {
+            o.duration = std::atof(value);
+        } else if (arg == "--publish-rate") {
+            o.publishRate = std::atof(value);
+        } else if (arg == "--nick-prefix") {
+            o.nickPrefix = value;
+        } else if (arg == "--json") {
+            o.jsonPath = value;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if (o.scenario == "fanout") {
+        // 全員が #fanout の1チャンネルだけに参加する
+        o.channels = 1;
+        o.joinsPerClient = 1;
+    } else if (o.scenario != "load" && o.scenario != "churn") {
+        std::cerr << "Unknown scenario: " << o.scenario << std::endl;
+        return false;
+    }
+    if (o.hold) {
+        // 保持中の接続は何も送らず、解放後すぐに QUIT する
+        o.messageRate = 0;
+        o.duration = 0;
+    }
+    if (o.sourceAddresses < 1 || o.sourceAddresses > 254) {
+        std::cerr << "--source-addrs must be between 1 and 254" << std::endl;
+        return false;
+    }
+    if (o.clients <= 0 || o.threads <= 0 || o.port <= 0 || o.channels < 0 ||
+        o.joinsPerClient < 0 || o.joinsPerClient > o.channels) {
+        std::cerr << "Invalid option values (check --clients/--threads/--port/--joins)"
+                  << std::endl;
+        return false;
+    }
+    if (o.threads > o.clients) {
+        o.threads = o.clients;
+    }
+    return true;
+}
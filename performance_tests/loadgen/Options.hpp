@@ -0,0 +1,41 @@
+#ifndef OPTIONS_HPP
+#define OPTIONS_HPP
+
+#include <string>
+
+/**
+ * @brief 負荷生成の設定 (コマンドライン引数から作る)
+ */
+struct Options {
+    std::string scenario;  // "load" / "fanout" / "churn"
+    std::string host;
+    int port;
+    std::string password;
+    int sourceAddresses;   // 127.0.0.1 から順に bind する送信元アドレスの数 (1 は bind しない)
+    int serverPid;         // 0 でなければ計測中のサーバー CPU 使用率を /proc から読む
+
+    int clients;           // 総接続数
+    int threads;           // epoll ワーカースレッド数
+    double connectRate;    // 全体の接続開始レート (接続/秒, 0 は無制限)
+    double setupTimeout;   // 登録・JOIN 完了までの待ち時間 (秒)
+
+    int channels;          // チャンネル数 (#lg0 ... #lgN-1)
+    std::string channelPrefix; // チャンネル名の接頭辞 (# の後ろ)
+    int joinsPerClient;    // 各クライアントが JOIN するチャンネル数
+    double messageRate;    // クライアントあたりの PRIVMSG 送信レート (通数/秒)
+    int payloadSize;       // PRIVMSG 本文のバイト数 (タイムスタンプ込み)
+    double duration;       // 計測時間 (秒)
+    double publishRate;    // fanout: 送信者1人の PRIVMSG 送信レート (通数/秒)
+
+    std::string nickPrefix;
+    std::string jsonPath;  // 空でなければ結果を JSON で書き出す
+    bool quiet;
+    bool hold;             // 準備完了後 "ready" を出力し、標準入力が閉じられるまで接続を保つ
+
+    Options();
+};
+
+// 引数を解釈する。--help またはエラー時は usage を表示して false を返す
+bool parseOptions(int argc, char **argv, Options &options);
+
+#endif
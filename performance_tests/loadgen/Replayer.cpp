@@ -0,0 +1,446 @@
+#include "Replayer.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const int kMaxEvents = 1024;
+static const int kMaxWaitMillis = 50;
+static const uint64_t kConnectTimeoutNanos = 10000000000ULL;
+
+static uint64_t monotonicNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+static double toMicros(uint64_t nanos) { return static_cast<double>(nanos) / 1000.0; }
+
+static double perSecond(uint64_t count, uint64_t nanos) {
+    return nanos > 0 ? static_cast<double>(count) * 1e9 / static_cast<double>(nanos) : 0.0;
+}
+
+ReplayOptions::ReplayOptions()
+    : host("127.0.0.1"), port(6667), mode("paced"), speed(1.0), drain(2.0) {}
+
+Replayer::Connection::Connection()
+    : fd(-1), state(PENDING), writeWanted(false), nextLine(0), outOffset(0), replies(0),
+      lastActivity(0), closeDue(0) {}
+
+Replayer::Replayer(const ReplayOptions &options, const std::vector<CapturedSession> &sessions)
+    : _options(options), _sessions(sessions), _connections(sessions.size()), _epollFd(-1),
+      _done(0), _readBuffer(64 * 1024), _startTime(0), _lastLineSentAt(0), _endTime(0),
+      _linesTotal(0), _linesSent(0), _bytesSent(0), _bytesReceived(0), _connectErrors(0),
+      _earlyCloses(0) {
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        _linesTotal += sessions[i].lines.size();
+    }
+}
+
+Replayer::~Replayer() {
+    for (size_t i = 0; i < _connections.size(); ++i) {
+        if (_connections[i].fd >= 0) {
+            close(_connections[i].fd);
+        }
+    }
+    if (_epollFd >= 0) {
+        close(_epollFd);
+    }
+}
+
+// キャプチャ上の時刻 (マイクロ秒) を再生時の予定時刻 (ナノ秒) に変換する
+uint64_t Replayer::dueAt(uint64_t capturedMicros) const {
+    if (_options.mode == "max") {
+        return _startTime;
+    }
+    return _startTime + static_cast<uint64_t>(static_cast<double>(capturedMicros) * 1000.0 /
+                                              _options.speed);
+}
+
+bool Replayer::run() {
+    _epollFd = epoll_create1(0);
+    if (_epollFd < 0) {
+        perror("epoll_create1");
+        return false;
+    }
+    _startTime = monotonicNanos();
+    for (size_t i = 0; i < _sessions.size(); ++i) {
+        _events.push(Event(dueAt(_sessions[i].openAt), i));
+    }
+
+    struct epoll_event events[kMaxEvents];
+    uint64_t lastIdleCheck = _startTime;
+    while (_done < _connections.size()) {
+        uint64_t now = monotonicNanos();
+        runDueEvents(now);
+        if (now - lastIdleCheck > 50000000ULL) {
+            checkIdle(now);
+            lastIdleCheck = now;
+        }
+
+        int timeout = kMaxWaitMillis;
+        if (!_events.empty()) {
+            uint64_t due = _events.top().first;
+            timeout = due <= now ? 0 : static_cast<int>(std::min<uint64_t>(
+                                           (due - now) / 1000000ULL, kMaxWaitMillis));
+        }
+        int n = epoll_wait(_epollFd, events, kMaxEvents, timeout);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            return false;
+        }
+        for (int i = 0; i < n; ++i) {
+            handleEvent(events[i].data.u32, events[i].events);
+        }
+    }
+    _endTime = monotonicNanos();
+    return true;
+}
+
+void Replayer::runDueEvents(uint64_t now) {
+    while (!_events.empty() && _events.top().first <= now) {
+        size_t index = _events.top().second;
+        _events.pop();
+        if (_connections[index].state == PENDING) {
+            startConnection(index, now);
+        } else if (_connections[index].state == OPEN) {
+            sendDueLines(index, now);
+        }
+    }
+}
+
+void Replayer::startConnection(size_t index, uint64_t now) {
+    Connection &conn = _connections[index];
+    conn.lastActivity = now;
+    conn.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (conn.fd < 0) {
+        ++_connectErrors;
+        finish(conn, false);
+        return;
+    }
+    int one = 1;
+    setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(_options.port));
+    inet_pton(AF_INET, _options.host.c_str(), &addr.sin_addr);
+    if (connect(conn.fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 &&
+        errno != EINPROGRESS) {
+        ++_connectErrors;
+        finish(conn, false);
+        return;
+    }
+    conn.state = CONNECTING;
+
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.u32 = static_cast<uint32_t>(index);
+    epoll_ctl(_epollFd, EPOLL_CTL_ADD, conn.fd, &ev);
+    conn.writeWanted = true;
+}
+
+void Replayer::handleEvent(size_t index, uint32_t events) {
+    Connection &conn = _connections[index];
+    if (conn.state == DONE) {
+        return;
+    }
+    if (conn.state == CONNECTING) {
+        if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+            handleConnected(index);
+        }
+        return;
+    }
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        handleReadable(conn);
+    }
+    if (conn.state == OPEN && (events & EPOLLOUT)) {
+        flush(conn);
+        if (conn.state == OPEN) {
+            updateEvents(index);
+        }
+    }
+}
+
+void Replayer::handleConnected(size_t index) {
+    Connection &conn = _connections[index];
+    int error = 0;
+    socklen_t len = sizeof(error);
+    getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &error, &len);
+    if (error != 0) {
+        ++_connectErrors;
+        finish(conn, false);
+        return;
+    }
+    conn.state = OPEN;
+    const CapturedSession &session = _sessions[index];
+    if (_options.mode != "max" && session.closeAt > 0) {
+        conn.closeDue = dueAt(session.closeAt);
+    }
+    sendDueLines(index, monotonicNanos());
+}
+
+// 予定時刻を過ぎた行を送り、残りがあれば次の行の予定をイベントに積む
+void Replayer::sendDueLines(size_t index, uint64_t now) {
+    Connection &conn = _connections[index];
+    const CapturedSession &session = _sessions[index];
+    while (conn.nextLine < session.lines.size()) {
+        uint64_t due = dueAt(session.lineAt[conn.nextLine]);
+        if (due > now) {
+            _events.push(Event(due, index));
+            break;
+        }
+        if (_options.mode != "max") {
+            _scheduleLag.record(now - due);
+        }
+        queueLine(conn, session.lines[conn.nextLine]);
+        ++conn.nextLine;
+    }
+    flush(conn);
+    if (conn.state == OPEN) {
+        updateEvents(index);
+    }
+}
+
+// 記録された行をそのまま送る。--password があれば PASS の引数だけ差し替える
+void Replayer::queueLine(Connection &conn, const std::string &line) {
+    if (!_options.password.empty() && line.size() >= 5 &&
+        strncasecmp(line.c_str(), "PASS ", 5) == 0) {
+        conn.out += "PASS " + _options.password;
+    } else {
+        conn.out += line;
+    }
+    conn.out += "\r\n";
+    ++_linesSent;
+}
+
+void Replayer::flush(Connection &conn) {
+    while (conn.outOffset < conn.out.size()) {
+        ssize_t n = send(conn.fd, conn.out.data() + conn.outOffset, conn.out.size() - conn.outOffset,
+                         MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.outOffset += static_cast<size_t>(n);
+            _bytesSent += static_cast<uint64_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        finish(conn, true);
+        return;
+    }
+    if (conn.outOffset == conn.out.size()) {
+        conn.out.clear();
+        conn.outOffset = 0;
+        uint64_t now = monotonicNanos();
+        conn.lastActivity = now;
+        if (conn.nextLine == _sessions[&conn - &_connections[0]].lines.size()) {
+            _lastLineSentAt = std::max(_lastLineSentAt, now);
+        }
+    } else if (conn.outOffset > conn.out.size() / 2) {
+        conn.out.erase(0, conn.outOffset);
+        conn.outOffset = 0;
+    }
+}
+
+// 応答は本文を見ずに行数 ('\n' の数) だけ数える
+void Replayer::handleReadable(Connection &conn) {
+    while (true) {
+        ssize_t n = recv(conn.fd, &_readBuffer[0], _readBuffer.size(), 0);
+        if (n > 0) {
+            _bytesReceived += static_cast<uint64_t>(n);
+            conn.replies += static_cast<uint64_t>(
+                std::count(_readBuffer.begin(), _readBuffer.begin() + n, '\n'));
+            conn.lastActivity = monotonicNanos();
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        // サーバーが閉じた。送り残しがあれば早期切断として数える
+        const CapturedSession &session = _sessions[&conn - &_connections[0]];
+        finish(conn, conn.nextLine < session.lines.size() || !conn.out.empty());
+        return;
+    }
+}
+
+// 送信待ちがある間だけ EPOLLOUT を監視する
+void Replayer::updateEvents(size_t index) {
+    Connection &conn = _connections[index];
+    bool want = conn.outOffset < conn.out.size();
+    if (want == conn.writeWanted) {
+        return;
+    }
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = want ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    ev.data.u32 = static_cast<uint32_t>(index);
+    epoll_ctl(_epollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+    conn.writeWanted = want;
+}
+
+// 全行を送り終え、--drain 秒何も届かなくなった接続を閉じる
+void Replayer::checkIdle(uint64_t now) {
+    uint64_t drain = static_cast<uint64_t>(_options.drain * 1e9);
+    for (size_t i = 0; i < _connections.size(); ++i) {
+        Connection &conn = _connections[i];
+        if (conn.state == CONNECTING && now - conn.lastActivity > kConnectTimeoutNanos) {
+            ++_connectErrors;
+            finish(conn, false);
+        } else if (conn.state == OPEN && conn.nextLine == _sessions[i].lines.size() &&
+                   conn.out.empty() && now - conn.lastActivity > drain && now >= conn.closeDue) {
+            finish(conn, false);
+        }
+    }
+}
+
+void Replayer::finish(Connection &conn, bool early) {
+    if (conn.state == DONE) {
+        return;
+    }
+    if (early) {
+        ++_earlyCloses;
+    }
+    if (conn.fd >= 0) {
+        epoll_ctl(_epollFd, EPOLL_CTL_DEL, conn.fd, NULL);
+        close(conn.fd);
+        conn.fd = -1;
+    }
+    conn.state = DONE;
+    ++_done;
+}
+
+namespace {
+
+struct Divergence {
+    uint64_t expected;
+    uint64_t received;
+    uint64_t diverged;     // 応答数が一致しなかったセッション数
+    uint64_t absoluteDiff; // |received - expected| の合計
+    std::vector<std::pair<uint64_t, size_t> > worst; // (|差|, sessions の位置) の大きい順
+
+    Divergence() : expected(0), received(0), diverged(0), absoluteDiff(0) {}
+};
+
+uint64_t absDiff(uint64_t a, uint64_t b) { return a > b ? a - b : b - a; }
+
+} // namespace
+
+static Divergence computeDivergence(const std::vector<CapturedSession> &sessions,
+                                    const std::vector<uint64_t> &replies) {
+    Divergence d;
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        d.expected += sessions[i].replies;
+        d.received += replies[i];
+        uint64_t diff = absDiff(replies[i], sessions[i].replies);
+        if (diff > 0) {
+            ++d.diverged;
+            d.absoluteDiff += diff;
+            d.worst.push_back(std::make_pair(diff, i));
+        }
+    }
+    std::sort(d.worst.rbegin(), d.worst.rend());
+    if (d.worst.size() > 5) {
+        d.worst.resize(5);
+    }
+    return d;
+}
+
+void Replayer::printReport() const {
+    std::vector<uint64_t> replies;
+    for (size_t i = 0; i < _connections.size(); ++i) {
+        replies.push_back(_connections[i].replies);
+    }
+    Divergence d = computeDivergence(_sessions, replies);
+    uint64_t sendNanos = _lastLineSentAt > _startTime ? _lastLineSentAt - _startTime : 0;
+    uint64_t totalNanos = _endTime - _startTime;
+
+    std::cout << "\n=== irc_replay report ===\n"
+              << "file " << _options.file << ", mode " << _options.mode;
+    if (_options.mode != "max") {
+        std::cout << " (speed " << _options.speed << "x)";
+    }
+    std::cout << ", sessions " << _sessions.size() << "\n\n"
+              << std::fixed << std::setprecision(2)
+              << "sent        : " << _linesSent << "/" << _linesTotal << " lines in "
+              << sendNanos / 1e9 << " s (" << std::setprecision(1)
+              << perSecond(_linesSent, sendNanos) << " lines/s), " << _bytesSent << " bytes\n"
+              << "received    : " << d.received << " lines (" << perSecond(d.received, totalNanos)
+              << " lines/s over " << std::setprecision(2) << totalNanos / 1e9 << " s), "
+              << _bytesReceived << " bytes\n"
+              << "connections : connect errors " << _connectErrors << ", closed early "
+              << _earlyCloses << "\n"
+              << "divergence  : expected " << d.expected << " replies, received " << d.received
+              << ", " << d.diverged << "/" << _sessions.size() << " sessions differ (sum |diff| "
+              << d.absoluteDiff << ")\n";
+    for (size_t i = 0; i < d.worst.size(); ++i) {
+        size_t index = d.worst[i].second;
+        std::cout << "  session " << _sessions[index].id << ": expected " << _sessions[index].replies
+                  << ", received " << replies[index] << "\n";
+    }
+    if (_options.mode != "max") {
+        std::cout << std::setprecision(1) << "schedule lag: p50 "
+                  << toMicros(_scheduleLag.percentile(50)) << " us, p99 "
+                  << toMicros(_scheduleLag.percentile(99)) << " us, max "
+                  << toMicros(_scheduleLag.max()) << " us\n";
+    }
+    std::cout << std::endl;
+}
+
+bool Replayer::writeJsonReport(const std::string &path) const {
+    std::ofstream os(path.c_str());
+    if (!os) {
+        std::cerr << "Cannot write " << path << std::endl;
+        return false;
+    }
+    std::vector<uint64_t> replies;
+    for (size_t i = 0; i < _connections.size(); ++i) {
+        replies.push_back(_connections[i].replies);
+    }
+    Divergence d = computeDivergence(_sessions, replies);
+    uint64_t sendNanos = _lastLineSentAt > _startTime ? _lastLineSentAt - _startTime : 0;
+    uint64_t totalNanos = _endTime - _startTime;
+
+    os << std::fixed << std::setprecision(3);
+    os << "{\n"
+       << "  \"tool\": \"irc_replay\",\n"
+       << "  \"config\": {\"file\": \"" << _options.file << "\", \"mode\": \"" << _options.mode
+       << "\", \"speed\": " << _options.speed << ", \"drain\": " << _options.drain << "},\n"
+       << "  \"sessions\": " << _sessions.size() << ",\n"
+       << "  \"send_seconds\": " << sendNanos / 1e9 << ",\n"
+       << "  \"total_seconds\": " << totalNanos / 1e9 << ",\n"
+       << "  \"counters\": {\"lines_total\": " << _linesTotal << ", \"lines_sent\": "
+       << _linesSent << ", \"bytes_sent\": " << _bytesSent << ", \"bytes_received\": "
+       << _bytesReceived << ", \"connect_errors\": " << _connectErrors
+       << ", \"closed_early\": " << _earlyCloses << "},\n"
+       << "  \"throughput\": {\"lines_sent_per_s\": " << perSecond(_linesSent, sendNanos)
+       << ", \"replies_per_s\": " << perSecond(d.received, totalNanos) << "},\n"
+       << "  \"divergence\": {\"expected_replies\": " << d.expected
+       << ", \"received_replies\": " << d.received << ", \"sessions_diverged\": " << d.diverged
+       << ", \"sum_abs_diff\": " << d.absoluteDiff << "},\n"
+       << "  \"schedule_lag_us\": {\"p50\": " << toMicros(_scheduleLag.percentile(50))
+       << ", \"p99\": " << toMicros(_scheduleLag.percentile(99))
+       << ", \"max\": " << toMicros(_scheduleLag.max()) << "}\n"
+       << "}\n";
+    return true;
+}
@@ -0,0 +1,98 @@
+#ifndef REPLAYER_HPP
+#define REPLAYER_HPP
+
+#include "Capture.hpp"
+#include "Histogram.hpp"
+#include <functional>
+#include <queue>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief irc_replay の設定
+ */
+struct ReplayOptions {
+    std::string file;      // capture_proxy.py が書いた .irccap
+    std::string host;
+    int port;
+    std::string password;  // 空でなければ PASS の引数をこれに置き換える
+    std::string mode;      // "paced" (記録どおりの間隔) または "max" (待たずに送る)
+    double speed;          // paced: 再生速度の倍率
+    double drain;          // 最後の送受信からこの秒数だけ応答を待ってから閉じる
+    std::string jsonPath;
+
+    ReplayOptions();
+};
+
+/**
+ * @brief キャプチャしたセッションを1スレッドの epoll で再生する
+ *
+ * セッションごとに接続を1本張り、記録された行を paced では記録時刻どおりに、
+ * max では接続直後にまとめて送る。受信した行数をキャプチャ時の応答数と比べる。
+ */
+class Replayer {
+  public:
+    Replayer(const ReplayOptions &options, const std::vector<CapturedSession> &sessions);
+    ~Replayer();
+
+    bool run();
+    void printReport() const;
+    bool writeJsonReport(const std::string &path) const;
+
+  private:
+    enum State { PENDING, CONNECTING, OPEN, DONE };
+
+    struct Connection {
+        int fd;
+        State state;
+        bool writeWanted;
+        size_t nextLine;
+        std::string out;
+        size_t outOffset;
+        uint64_t replies;
+        uint64_t lastActivity;
+        uint64_t closeDue;   // paced: キャプチャで閉じた時刻 (これより前には閉じない)
+
+        Connection();
+    };
+
+    // (予定時刻, セッション番号) の最小ヒープ。接続開始と paced の行送信に使う
+    typedef std::pair<uint64_t, size_t> Event;
+    typedef std::priority_queue<Event, std::vector<Event>, std::greater<Event> > EventQueue;
+
+    uint64_t dueAt(uint64_t capturedMicros) const;
+    void runDueEvents(uint64_t now);
+    void startConnection(size_t index, uint64_t now);
+    void handleEvent(size_t index, uint32_t events);
+    void handleConnected(size_t index);
+    void handleReadable(Connection &conn);
+    void sendDueLines(size_t index, uint64_t now);
+    void queueLine(Connection &conn, const std::string &line);
+    void flush(Connection &conn);
+    void updateEvents(size_t index);
+    void checkIdle(uint64_t now);
+    void finish(Connection &conn, bool early);
+
+    const ReplayOptions &_options;
+    const std::vector<CapturedSession> &_sessions;
+    std::vector<Connection> _connections;
+    EventQueue _events;
+    int _epollFd;
+    size_t _done;
+    std::vector<char> _readBuffer;
+
+    uint64_t _startTime;
+    uint64_t _lastLineSentAt;
+    uint64_t _endTime;
+    uint64_t _linesTotal;
+    uint64_t _linesSent;
+    uint64_t _bytesSent;
+    uint64_t _bytesReceived;
+    uint64_t _connectErrors;
+    uint64_t _earlyCloses;   // 全行を送り終える前にサーバーに切断された
+    Histogram _scheduleLag;  // paced: 予定時刻からの送信の遅れ
+};
+
+#endif
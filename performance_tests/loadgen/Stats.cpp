@@ -0,0 +1,185 @@
+#include "Stats.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+Stats::Stats()
+    : connectOk(0), connectErrors(0), registered(0), registerErrors(0), joinErrors(0),
+      setupTimeouts(0), quitTimeouts(0), cycles(0), disconnects(0), errorReplies(0), messagesSent(0), messagesReceived(0),
+      sendSkipped(0), bytesSent(0), bytesReceived(0), serverCpuPercent(-1.0) {}
+
+void Stats::merge(const Stats &o) {
+    connectOk += o.connectOk;
+    connectErrors += o.connectErrors;
+    registered += o.registered;
+    registerErrors += o.registerErrors;
+    joinErrors += o.joinErrors;
+    setupTimeouts += o.setupTimeouts;
+    quitTimeouts += o.quitTimeouts;
+    cycles += o.cycles;
+    disconnects += o.disconnects;
+    errorReplies += o.errorReplies;
+    messagesSent += o.messagesSent;
+    messagesReceived += o.messagesReceived;
+    sendSkipped += o.sendSkipped;
+    bytesSent += o.bytesSent;
+    bytesReceived += o.bytesReceived;
+    connectLatency.merge(o.connectLatency);
+    registerLatency.merge(o.registerLatency);
+    joinLatency.merge(o.joinLatency);
+    deliveryLatency.merge(o.deliveryLatency);
+    quitLatency.merge(o.quitLatency);
+    cycleLatency.merge(o.cycleLatency);
+    if (fanoutSamples.size() < o.fanoutSamples.size()) {
+        fanoutSamples.resize(o.fanoutSamples.size());
+    }
+    for (size_t i = 0; i < o.fanoutSamples.size(); ++i) {
+        fanoutSamples[i].insert(fanoutSamples[i].end(), o.fanoutSamples[i].begin(),
+                                o.fanoutSamples[i].end());
+    }
+}
+
+FanoutSummary::FanoutSummary(const Stats &stats, int listeners) : messages(0), complete(0) {
+    for (size_t i = 0; i < stats.fanoutSamples.size(); ++i) {
+        std::vector<uint32_t> samples = stats.fanoutSamples[i];
+        if (samples.empty()) {
+            continue;
+        }
+        ++messages;
+        if (static_cast<int>(samples.size()) >= listeners) {
+            ++complete;
+        }
+        std::vector<uint32_t>::iterator middle = samples.begin() + samples.size() / 2;
+        std::nth_element(samples.begin(), middle, samples.end());
+        // 分布はナノ秒で持つ (他のヒストグラムと単位を揃える)
+        median.record(static_cast<uint64_t>(*middle) * 1000);
+        first.record(static_cast<uint64_t>(*std::min_element(samples.begin(), samples.end())) * 1000);
+        last.record(static_cast<uint64_t>(*std::max_element(samples.begin(), samples.end())) * 1000);
+    }
+}
+
+static double toMicros(uint64_t nanos) { return static_cast<double>(nanos) / 1000.0; }
+
+static double perSecond(uint64_t count, double seconds) {
+    return seconds > 0 ? static_cast<double>(count) / seconds : 0.0;
+}
+
+static void printLatencyRow(const char *name, const Histogram &h) {
+    std::cout << std::left << std::setw(10) << name << std::right << std::setw(10) << h.count()
+              << std::fixed << std::setprecision(1) << std::setw(12) << toMicros(h.percentile(50))
+              << std::setw(12) << toMicros(h.percentile(90)) << std::setw(12)
+              << toMicros(h.percentile(99)) << std::setw(12) << toMicros(h.percentile(99.9))
+              << std::setw(12) << toMicros(h.max()) << std::endl;
+}
+
+void printReport(const Options &o, const Stats &s, double measuredSeconds) {
+    std::cout << "\n=== irc_loadgen report ===\n"
+              << "clients " << o.clients << ", threads " << o.threads << ", channels "
+              << o.channels << ", joins/client " << o.joinsPerClient << ", msg-rate "
+              << o.messageRate << "/s, measured " << std::fixed << std::setprecision(2)
+              << measuredSeconds << " s\n\n";
+
+    std::cout << "connections : ok " << s.connectOk << ", errors " << s.connectErrors
+              << ", registered " << s.registered << ", register errors " << s.registerErrors
+              << ", setup timeouts " << s.setupTimeouts << ", join errors " << s.joinErrors
+              << ", disconnects " << s.disconnects << "\n";
+    std::cout << "messages    : sent " << s.messagesSent << " (" << std::setprecision(1)
+              << perSecond(s.messagesSent, measuredSeconds) << "/s), received "
+              << s.messagesReceived << " (" << perSecond(s.messagesReceived, measuredSeconds)
+              << "/s), skipped " << s.sendSkipped << ", error replies " << s.errorReplies << "\n";
+    std::cout << "bytes       : sent " << s.bytesSent << ", received " << s.bytesReceived
+              << "\n\n";
+
+    std::cout << std::left << std::setw(10) << "latency" << std::right << std::setw(10)
+              << "count" << std::setw(12) << "p50 us" << std::setw(12) << "p90 us"
+              << std::setw(12) << "p99 us" << std::setw(12) << "p99.9 us" << std::setw(12)
+              << "max us" << std::endl;
+    printLatencyRow("connect", s.connectLatency);
+    printLatencyRow("register", s.registerLatency);
+    printLatencyRow("join", s.joinLatency);
+    printLatencyRow("delivery", s.deliveryLatency);
+
+    if (o.scenario == "churn") {
+        std::cout << "\nchurn       : " << s.cycles << " cycles ("
+                  << perSecond(s.cycles, measuredSeconds) << "/s), quit timeouts "
+                  << s.quitTimeouts << "\n";
+        printLatencyRow("quit", s.quitLatency);
+        printLatencyRow("cycle", s.cycleLatency);
+    }
+    if (o.scenario == "fanout") {
+        FanoutSummary f(s, o.clients - 1);
+        std::cout << "\nfanout      : " << f.messages << " messages to " << o.clients - 1
+                  << " listeners, complete " << f.complete << "\n";
+        printLatencyRow("first", f.first);
+        printLatencyRow("median", f.median);
+        printLatencyRow("last", f.last);
+    }
+    if (s.serverCpuPercent >= 0) {
+        std::cout << "\nserver cpu  : " << std::setprecision(1) << s.serverCpuPercent << " %\n";
+    }
+}
+
+static void writeLatency(std::ostream &os, const char *name, const Histogram &h, bool last) {
+    os << "    \"" << name << "\": {\"count\": " << h.count() << ", \"mean\": " << toMicros(
+                                                                               static_cast<uint64_t>(h.mean()))
+       << ", \"p50\": " << toMicros(h.percentile(50)) << ", \"p90\": "
+       << toMicros(h.percentile(90)) << ", \"p99\": " << toMicros(h.percentile(99))
+       << ", \"p999\": " << toMicros(h.percentile(99.9)) << ", \"max\": " << toMicros(h.max())
+       << "}" << (last ? "\n" : ",\n");
+}
+
+bool writeJsonReport(const std::string &path, const Options &o, const Stats &s,
+                     double measuredSeconds) {
+    std::ofstream os(path.c_str());
+    if (!os) {
+        std::cerr << "Cannot write " << path << std::endl;
+        return false;
+    }
+    os << std::fixed << std::setprecision(3);
+    os << "{\n"
+       << "  \"tool\": \"irc_loadgen\",\n"
+       << "  \"scenario\": \"" << o.scenario << "\",\n"
+       << "  \"config\": {\"clients\": " << o.clients << ", \"threads\": " << o.threads
+       << ", \"connect_rate\": " << o.connectRate << ", \"channels\": " << o.channels
+       << ", \"joins\": " << o.joinsPerClient << ", \"msg_rate\": " << o.messageRate
+       << ", \"payload\": " << o.payloadSize << ", \"duration\": " << o.duration
+       << ", \"publish_rate\": " << o.publishRate << "},\n"
+       << "  \"measured_seconds\": " << measuredSeconds << ",\n"
+       << "  \"server_cpu_percent\": " << s.serverCpuPercent << ",\n"
+       << "  \"counters\": {\"connect_ok\": " << s.connectOk
+       << ", \"connect_errors\": " << s.connectErrors << ", \"registered\": " << s.registered
+       << ", \"register_errors\": " << s.registerErrors << ", \"setup_timeouts\": "
+       << s.setupTimeouts << ", \"quit_timeouts\": " << s.quitTimeouts
+       << ", \"cycles\": " << s.cycles << ", \"join_errors\": " << s.joinErrors
+       << ", \"disconnects\": " << s.disconnects << ", \"error_replies\": " << s.errorReplies
+       << ", \"messages_sent\": " << s.messagesSent << ", \"messages_received\": "
+       << s.messagesReceived << ", \"send_skipped\": " << s.sendSkipped
+       << ", \"bytes_sent\": " << s.bytesSent << ", \"bytes_received\": " << s.bytesReceived
+       << "},\n"
+       << "  \"throughput\": {\"messages_sent_per_s\": "
+       << perSecond(s.messagesSent, measuredSeconds) << ", \"messages_received_per_s\": "
+       << perSecond(s.messagesReceived, measuredSeconds)
+       << ", \"cycles_per_s\": " << perSecond(s.cycles, measuredSeconds) << "},\n"
+       << "  \"latency_us\": {\n";
+    writeLatency(os, "connect", s.connectLatency, false);
+    writeLatency(os, "register", s.registerLatency, false);
+    writeLatency(os, "join", s.joinLatency, false);
+    writeLatency(os, "delivery", s.deliveryLatency, false);
+    writeLatency(os, "quit", s.quitLatency, false);
+    writeLatency(os, "cycle", s.cycleLatency, true);
+    os << "  }";
+    if (o.scenario == "fanout") {
+        FanoutSummary f(s, o.clients - 1);
+        os << ",\n  \"fanout\": {\"listeners\": " << o.clients - 1 << ", \"messages\": "
+           << f.messages << ", \"complete\": " << f.complete << ",\n";
+        writeLatency(os, "first", f.first, false);
+        writeLatency(os, "median", f.median, false);
+        writeLatency(os, "last", f.last, true);
+        os << "  }";
+    }
+    os << "\n}\n";
+    return static_cast<bool>(os);
+}
@@ -0,0 +1,65 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include "Histogram.hpp"
+#include "Options.hpp"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief ワーカーごとの計測値 (ワーカーだけが書き込み、終了後にまとめる)
+ * レイテンシはすべてナノ秒で記録する。
+ */
+struct Stats {
+    uint64_t connectOk;
+    uint64_t connectErrors;
+    uint64_t registered;
+    uint64_t registerErrors;   // 433 / 464 などで登録できなかった
+    uint64_t joinErrors;       // JOIN への 4xx 応答
+    uint64_t setupTimeouts;    // --setup-timeout 内に登録・JOIN が終わらなかった
+    uint64_t quitTimeouts;     // churn: QUIT の後 --setup-timeout 内に切断されなかった
+    uint64_t cycles;           // churn: 接続 -> 登録 -> JOIN -> QUIT を終えた回数
+    uint64_t disconnects;      // こちらが QUIT する前にサーバーに切断された
+    uint64_t errorReplies;     // 4xx / 5xx の応答の総数
+    uint64_t messagesSent;     // 計測時間内に送った PRIVMSG
+    uint64_t messagesReceived; // 受信したタイムスタンプ付き PRIVMSG
+    uint64_t sendSkipped;      // 送信待ちが溜まっていたため送らなかった PRIVMSG
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+
+    Histogram connectLatency;  // connect() 開始から接続完了まで
+    Histogram registerLatency; // connect() 開始から 001 まで
+    Histogram joinLatency;     // 001 から全チャンネルの 366 まで
+    Histogram deliveryLatency; // PRIVMSG の送信から受信まで
+    Histogram quitLatency;     // churn: QUIT から切断まで
+    Histogram cycleLatency;    // churn: connect() 開始から切断まで
+
+    // fanout: メッセージ番号ごとの全受信者のレイテンシ (マイクロ秒)
+    std::vector<std::vector<uint32_t> > fanoutSamples;
+
+    double serverCpuPercent;   // 計測中のサーバー CPU 使用率 (--server-pid がなければ -1)
+
+    Stats();
+    void merge(const Stats &other);
+};
+
+/**
+ * @brief fanout の集計: メッセージごとに最初・中央・最後の受信者のレイテンシを求め、
+ * その分布をメッセージ全体でまとめる
+ */
+struct FanoutSummary {
+    uint64_t messages;
+    uint64_t complete; // 全受信者に届いたメッセージ数
+    Histogram first;
+    Histogram median;
+    Histogram last;
+
+    FanoutSummary(const Stats &stats, int listeners);
+};
+
+void printReport(const Options &options, const Stats &stats, double measuredSeconds);
+bool writeJsonReport(const std::string &path, const Options &options, const Stats &stats,
+                     double measuredSeconds);
+
+#endif
@@ -0,0 +1,606 @@
+#include "Worker.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sstream>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// 送信待ちがこれを超えている接続には新しい PRIVMSG を積まない
+static const size_t kMaxPendingOutput = 64 * 1024;
+// 1回の epoll_wait で受け取るイベント数と待ち時間 (ミリ秒)
+static const int kMaxEvents = 256;
+static const int kWaitMillis = 1;
+// QUIT を送ってから切断を待つ時間
+static const uint64_t kQuitGraceNanos = 1000000000ULL;
+// churn で接続に失敗したとき、接続し直すまでの待ち時間
+static const uint64_t kRetryDelayNanos = 100000000ULL;
+// 計測用 PRIVMSG 本文の目印
+static const char kTag[] = "LG ";
+
+uint64_t nowNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+Worker::Connection::Connection()
+    : fd(-1), id(0), state(IDLE), settled(false), writeWanted(false), outOffset(0),
+      connectStart(0), registeredAt(0), quitSentAt(0), retryAt(0), joinsPending(0), nextTarget(0) {}
+
+Worker::Worker(const Options &options, Control &control, int firstClient, int clientCount)
+    : _options(options), _control(control), _epollFd(-1), _connections(clientCount),
+      _nextToStart(0), _openCount(0), _activeCount(0), _nextSender(0), _startTime(0), _lastSendTick(0),
+      _owedMessages(0.0), _sequence(0), _readBuffer(64 * 1024) {
+    for (int i = 0; i < clientCount; ++i) {
+        Connection &conn = _connections[i];
+        conn.id = firstClient + i;
+        // JOIN するチャンネルは id からずらして割り当て、全チャンネルに均等に散らす
+        for (int j = 0; j < options.joinsPerClient; ++j) {
+            conn.targets.push_back(channelFor((conn.id + j) % options.channels));
+        }
+        // JOIN しない場合は隣の id のクライアントに直接送る
+        if (conn.targets.empty()) {
+            conn.targets.push_back(nickFor((conn.id + 1) % options.clients));
+        }
+    }
+}
+
+Worker::~Worker() {
+    for (size_t i = 0; i < _connections.size(); ++i) {
+        if (_connections[i].fd >= 0) {
+            close(_connections[i].fd);
+        }
+    }
+    if (_epollFd >= 0) {
+        close(_epollFd);
+    }
+}
+
+std::string Worker::nickFor(int id) const {
+    std::ostringstream oss;
+    oss << _options.nickPrefix << id;
+    return oss.str();
+}
+
+std::string Worker::channelFor(int index) const {
+    if (_options.scenario == "fanout") {
+        return "#fanout";
+    }
+    std::ostringstream oss;
+    oss << "#" << _options.channelPrefix << index;
+    return oss.str();
+}
+
+void Worker::run() {
+    _epollFd = epoll_create1(0);
+    if (_epollFd < 0) {
+        perror("epoll_create1");
+        return;
+    }
+    _startTime = nowNanos();
+    _lastSendTick = _startTime;
+
+    struct epoll_event events[kMaxEvents];
+    uint64_t lastTimeoutCheck = _startTime;
+    bool quitSent = false;
+    uint64_t quitDeadline = 0;
+
+    while (true) {
+        uint64_t now = nowNanos();
+        int phase = _control.phase.load(std::memory_order_relaxed);
+
+        if (phase == PHASE_STOP && !quitSent) {
+            sendQuitAll();
+            quitSent = true;
+            quitDeadline = now + kQuitGraceNanos;
+        }
+        if (quitSent && (_openCount == 0 || now > quitDeadline)) {
+            break;
+        }
+        if (!quitSent) {
+            restartConnections(now);
+            startConnections(now);
+            if (now - lastTimeoutCheck > 100000000ULL) {
+                checkSetupTimeouts(now);
+                lastTimeoutCheck = now;
+            }
+            if (phase == PHASE_MEASURE) {
+                sendMessages(now);
+            } else {
+                _lastSendTick = now;
+            }
+        }
+
+        int n = epoll_wait(_epollFd, events, kMaxEvents, kWaitMillis);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            handleEvent(_connections[events[i].data.u32], events[i].events);
+        }
+    }
+
+    for (size_t i = 0; i < _connections.size(); ++i) {
+        if (_connections[i].state != CLOSED && _connections[i].fd >= 0) {
+            closeConnection(_connections[i], false);
+        }
+    }
+}
+
+// --connect-rate をスレッド数で割ったレートで新しい接続を開始する
+void Worker::startConnections(uint64_t now) {
+    size_t allowed = _connections.size();
+    if (_options.connectRate > 0) {
+        double perThread = _options.connectRate / _options.threads;
+        double elapsed = static_cast<double>(now - _startTime) / 1e9;
+        allowed = static_cast<size_t>(elapsed * perThread) + 1;
+    }
+    // 無制限でも1周で大量に connect() しすぎないようにする
+    size_t budget = 512;
+    while (_nextToStart < _connections.size() && _nextToStart < allowed && budget-- > 0) {
+        startConnection(_connections[_nextToStart++], now);
+    }
+}
+
+void Worker::startConnection(Connection &conn, uint64_t now) {
+    conn.connectStart = now;
+    conn.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (conn.fd < 0) {
+        failConnection(conn, now);
+        return;
+    }
+    int one = 1;
+    setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(_options.port));
+    inet_pton(AF_INET, _options.host.c_str(), &addr.sin_addr);
+
+    // 1つの送信元アドレスで使えるエフェメラルポートは約28000個なので、
+    // それ以上の接続では 127.0.0.x を使い分ける
+    if (_options.sourceAddresses > 1) {
+        struct sockaddr_in source;
+        std::memset(&source, 0, sizeof(source));
+        source.sin_family = AF_INET;
+        source.sin_addr.s_addr = htonl(0x7f000001u + static_cast<uint32_t>(
+                                                         conn.id % _options.sourceAddresses));
+        if (bind(conn.fd, reinterpret_cast<struct sockaddr *>(&source), sizeof(source)) < 0) {
+            failConnection(conn, now);
+            return;
+        }
+    }
+
+    if (connect(conn.fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 &&
+        errno != EINPROGRESS) {
+        failConnection(conn, now);
+        return;
+    }
+    conn.state = CONNECTING;
+    ++_openCount;
+
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.u32 = static_cast<uint32_t>(&conn - &_connections[0]);
+    epoll_ctl(_epollFd, EPOLL_CTL_ADD, conn.fd, &ev);
+    conn.writeWanted = true;
+}
+
+// socket() / bind() / connect() がその場で失敗した接続を閉じる。
+// churn では fd や送信元ポートが空くのを待つため、少し間を置いてから接続し直す
+void Worker::failConnection(Connection &conn, uint64_t now) {
+    ++_stats.connectErrors;
+    if (conn.fd >= 0) {
+        close(conn.fd);
+        conn.fd = -1;
+    }
+    conn.state = CLOSED;
+    settle(conn);
+    if (_options.scenario == "churn" &&
+        _control.phase.load(std::memory_order_relaxed) != PHASE_STOP) {
+        conn.retryAt = now + kRetryDelayNanos;
+        _restartQueue.push_back(static_cast<size_t>(&conn - &_connections[0]));
+    }
+}
+
+void Worker::checkSetupTimeouts(uint64_t now) {
+    uint64_t limit = static_cast<uint64_t>(_options.setupTimeout * 1e9);
+    for (size_t i = 0; i < _nextToStart; ++i) {
+        Connection &conn = _connections[i];
+        if (conn.state == QUITTING && now - conn.quitSentAt > limit) {
+            ++_stats.quitTimeouts;
+            closeConnection(conn, false);
+        } else if ((conn.state == CONNECTING || conn.state == REGISTERING ||
+                    conn.state == JOINING) &&
+                   now - conn.connectStart > limit) {
+            ++_stats.setupTimeouts;
+            closeConnection(conn, false);
+        }
+    }
+}
+
+// churn: 閉じた接続を次のサイクルとして接続し直す
+// (epoll のイベント処理中に fd を差し替えないよう、ループの先頭でまとめて行う)。
+// retryAt がまだ来ていない接続は次の周回に回す
+void Worker::restartConnections(uint64_t now) {
+    if (_restartQueue.empty()) {
+        return;
+    }
+    // startConnection が失敗すると _restartQueue に積み直すため、入れ替えてから回す
+    _restartDue.swap(_restartQueue);
+    for (size_t i = 0; i < _restartDue.size(); ++i) {
+        Connection &conn = _connections[_restartDue[i]];
+        if (conn.retryAt > now) {
+            _restartQueue.push_back(_restartDue[i]);
+            continue;
+        }
+        conn.in.clear();
+        conn.out.clear();
+        conn.outOffset = 0;
+        conn.joinsPending = 0;
+        startConnection(conn, now);
+    }
+    _restartDue.clear();
+}
+
+// ACTIVE な接続を順番に回り、合計 (接続数 x --msg-rate) 通/秒で PRIVMSG を送る。
+// fanout では client 0 だけが --publish-rate 通/秒で送る
+void Worker::sendMessages(uint64_t now) {
+    bool fanout = _options.scenario == "fanout";
+    double rate = _options.messageRate * static_cast<double>(_activeCount);
+    if (fanout) {
+        bool publisher = !_connections.empty() && _connections[0].id == 0 &&
+                         _connections[0].state == ACTIVE;
+        rate = publisher ? _options.publishRate : 0.0;
+    }
+    double elapsed = static_cast<double>(now - _lastSendTick) / 1e9;
+    _lastSendTick = now;
+    if (rate <= 0) {
+        return;
+    }
+    _owedMessages += elapsed * rate;
+    // 長く止まっていた後に一気に送らない
+    double cap = fanout ? 1.0 : static_cast<double>(_activeCount);
+    if (_owedMessages > cap) {
+        _owedMessages = cap;
+    }
+
+    size_t scanned = 0;
+    while (_owedMessages >= 1.0 && scanned < _connections.size()) {
+        Connection &conn = _connections[fanout ? 0 : _nextSender];
+        _nextSender = (_nextSender + 1) % _connections.size();
+        ++scanned;
+        if (conn.state != ACTIVE) {
+            continue;
+        }
+        scanned = 0;
+        _owedMessages -= 1.0;
+        if (conn.out.size() - conn.outOffset > kMaxPendingOutput) {
+            ++_stats.sendSkipped;
+            continue;
+        }
+
+        const std::string &target = conn.targets[conn.nextTarget];
+        conn.nextTarget = (conn.nextTarget + 1) % conn.targets.size();
+
+        char head[64];
+        int len = std::snprintf(head, sizeof(head), "%s%llu %llu ", kTag,
+                                static_cast<unsigned long long>(_sequence++),
+                                static_cast<unsigned long long>(nowNanos()));
+        std::string line = "PRIVMSG " + target + " :" + std::string(head, len);
+        if (static_cast<int>(len) < _options.payloadSize) {
+            line.append(static_cast<size_t>(_options.payloadSize - len), 'x');
+        }
+        queue(conn, line);
+        flush(conn);
+        ++_stats.messagesSent;
+        _control.messagesSent.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Worker::sendQuitAll() {
+    for (size_t i = 0; i < _connections.size(); ++i) {
+        Connection &conn = _connections[i];
+        if (conn.state == CLOSED || conn.fd < 0) {
+            continue;
+        }
+        if (conn.state == CONNECTING) {
+            closeConnection(conn, false);
+            continue;
+        }
+        queue(conn, "QUIT :load test finished");
+        flush(conn);
+    }
+}
+
+void Worker::handleEvent(Connection &conn, uint32_t events) {
+    if (conn.state == CLOSED) {
+        return;
+    }
+    if (conn.state == CONNECTING) {
+        if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+            handleConnected(conn);
+        }
+        return;
+    }
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        handleReadable(conn);
+    }
+    if (conn.state != CLOSED && (events & EPOLLOUT)) {
+        flush(conn);
+    }
+}
+
+void Worker::handleConnected(Connection &conn) {
+    int error = 0;
+    socklen_t len = sizeof(error);
+    getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &error, &len);
+    if (error != 0) {
+        ++_stats.connectErrors;
+        closeConnection(conn, false);
+        return;
+    }
+    ++_stats.connectOk;
+    _stats.connectLatency.record(nowNanos() - conn.connectStart);
+
+    conn.state = REGISTERING;
+    std::string nick = nickFor(conn.id);
+    queue(conn, "PASS " + _options.password);
+    queue(conn, "NICK " + nick);
+    queue(conn, "USER " + nick + " 0 * :load generator");
+    flush(conn);
+}
+
+void Worker::handleReadable(Connection &conn) {
+    while (true) {
+        ssize_t n = recv(conn.fd, &_readBuffer[0], _readBuffer.size(), 0);
+        if (n > 0) {
+            _stats.bytesReceived += static_cast<uint64_t>(n);
+            conn.in.append(&_readBuffer[0], static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        // n == 0 (相手が切断) またはエラー。届いていた行は処理してから閉じる
+        processLines(conn);
+        closeConnection(conn, true);
+        return;
+    }
+    processLines(conn);
+}
+
+void Worker::processLines(Connection &conn) {
+    size_t start = 0;
+    size_t pos;
+    while (conn.state != CLOSED && (pos = conn.in.find('\n', start)) != std::string::npos) {
+        size_t end = pos;
+        if (end > start && conn.in[end - 1] == '\r') {
+            --end;
+        }
+        handleLine(conn, conn.in.substr(start, end - start));
+        start = pos + 1;
+    }
+    if (conn.state != CLOSED) {
+        conn.in.erase(0, start);
+    }
+}
+
+// ":prefix COMMAND params" の COMMAND だけを見て振り分ける
+void Worker::handleLine(Connection &conn, const std::string &line) {
+    size_t pos = 0;
+    if (!line.empty() && line[0] == ':') {
+        pos = line.find(' ');
+        if (pos == std::string::npos) {
+            return;
+        }
+        ++pos;
+    }
+    size_t end = line.find(' ', pos);
+    std::string command = line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+
+    if (command == "PING") {
+        std::string token = end == std::string::npos ? "" : line.substr(end + 1);
+        if (!token.empty() && token[0] == ':') {
+            token.erase(0, 1);
+        }
+        queue(conn, "PONG :" + token);
+        flush(conn);
+    } else if (command == "PRIVMSG") {
+        size_t text = line.find(" :", pos);
+        if (text != std::string::npos) {
+            handlePrivmsg(line, text + 2);
+        }
+    } else if (command.size() == 3 && command.find_first_not_of("0123456789") == std::string::npos) {
+        handleNumeric(conn, std::atoi(command.c_str()));
+    }
+}
+
+void Worker::handleNumeric(Connection &conn, int code) {
+    if (code >= 400) {
+        ++_stats.errorReplies;
+    }
+    if (conn.state == REGISTERING) {
+        if (code == 1) {
+            uint64_t now = nowNanos();
+            ++_stats.registered;
+            _stats.registerLatency.record(now - conn.connectStart);
+            conn.registeredAt = now;
+            if (_options.joinsPerClient == 0) {
+                becomeReady(conn, now);
+                return;
+            }
+            conn.state = JOINING;
+            conn.joinsPending = static_cast<int>(conn.targets.size());
+            for (size_t i = 0; i < conn.targets.size(); ++i) {
+                queue(conn, "JOIN " + conn.targets[i]);
+            }
+            flush(conn);
+        } else if (code >= 400) {
+            ++_stats.registerErrors;
+            closeConnection(conn, false);
+        }
+        return;
+    }
+    if (conn.state == JOINING) {
+        // 366 (RPL_ENDOFNAMES) が JOIN 完了の合図。JOIN へのエラー応答も1件と数える
+        if (code == 366 || code == 403 || code == 405 || code == 471 || code == 473 ||
+            code == 474 || code == 475) {
+            if (code != 366) {
+                ++_stats.joinErrors;
+            }
+            if (--conn.joinsPending == 0) {
+                uint64_t now = nowNanos();
+                _stats.joinLatency.record(now - conn.registeredAt);
+                becomeReady(conn, now);
+            }
+        }
+    }
+}
+
+// 登録と JOIN が終わった接続を ACTIVE にする。churn ではすぐに QUIT する
+void Worker::becomeReady(Connection &conn, uint64_t now) {
+    if (_options.scenario == "churn") {
+        conn.state = QUITTING;
+        conn.quitSentAt = now;
+        queue(conn, "QUIT :churn");
+        flush(conn);
+        return;
+    }
+    conn.state = ACTIVE;
+    ++_activeCount;
+    _control.active.fetch_add(1, std::memory_order_relaxed);
+    settle(conn);
+}
+
+// 本文 "LG <seq> <send_ns> ..." から配送レイテンシを求める
+void Worker::handlePrivmsg(const std::string &line, size_t textStart) {
+    if (line.compare(textStart, sizeof(kTag) - 1, kTag) != 0) {
+        return;
+    }
+    const char *p = line.c_str() + textStart + sizeof(kTag) - 1;
+    char *endPtr = NULL;
+    uint64_t sequence = std::strtoull(p, &endPtr, 10);
+    uint64_t sentAt = std::strtoull(endPtr, NULL, 10);
+    uint64_t now = nowNanos();
+    if (sentAt != 0 && now >= sentAt) {
+        _stats.deliveryLatency.record(now - sentAt);
+        // fanout ではメッセージごとに全受信者のレイテンシ (マイクロ秒) を残す
+        if (_options.scenario == "fanout") {
+            if (_stats.fanoutSamples.size() <= sequence) {
+                _stats.fanoutSamples.resize(sequence + 1);
+            }
+            uint64_t micros = (now - sentAt) / 1000;
+            _stats.fanoutSamples[sequence].push_back(
+                static_cast<uint32_t>(micros > UINT32_MAX ? UINT32_MAX : micros));
+        }
+    }
+    ++_stats.messagesReceived;
+    _control.messagesReceived.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Worker::queue(Connection &conn, const std::string &line) {
+    conn.out += line;
+    conn.out += "\r\n";
+}
+
+void Worker::flush(Connection &conn) {
+    while (conn.outOffset < conn.out.size()) {
+        ssize_t n = send(conn.fd, conn.out.data() + conn.outOffset, conn.out.size() - conn.outOffset,
+                         MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.outOffset += static_cast<size_t>(n);
+            _stats.bytesSent += static_cast<uint64_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        closeConnection(conn, true);
+        return;
+    }
+    if (conn.outOffset == conn.out.size()) {
+        conn.out.clear();
+        conn.outOffset = 0;
+    } else if (conn.outOffset > conn.out.size() / 2) {
+        conn.out.erase(0, conn.outOffset);
+        conn.outOffset = 0;
+    }
+    updateEvents(conn);
+}
+
+// 送信待ちがある間だけ EPOLLOUT を監視する
+void Worker::updateEvents(Connection &conn) {
+    bool want = conn.outOffset < conn.out.size();
+    if (want == conn.writeWanted) {
+        return;
+    }
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = want ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    ev.data.u32 = static_cast<uint32_t>(&conn - &_connections[0]);
+    epoll_ctl(_epollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+    conn.writeWanted = want;
+}
+
+void Worker::settle(Connection &conn) {
+    if (conn.settled) {
+        return;
+    }
+    conn.settled = true;
+    _control.settled.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Worker::closeConnection(Connection &conn, bool unexpected) {
+    if (conn.state == CLOSED) {
+        return;
+    }
+    bool running = _control.phase.load(std::memory_order_relaxed) != PHASE_STOP;
+    bool connectFailed = conn.state == CONNECTING;
+    if (conn.state == QUITTING && unexpected) {
+        // QUIT の後にサーバーが切断した = 1サイクル完了
+        if (running) {
+            uint64_t now = nowNanos();
+            ++_stats.cycles;
+            _stats.quitLatency.record(now - conn.quitSentAt);
+            _stats.cycleLatency.record(now - conn.connectStart);
+        }
+    } else if (unexpected && running) {
+        ++_stats.disconnects;
+    }
+    if (conn.state == ACTIVE) {
+        --_activeCount;
+        _control.active.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (conn.fd >= 0) {
+        epoll_ctl(_epollFd, EPOLL_CTL_DEL, conn.fd, NULL);
+        close(conn.fd);
+        conn.fd = -1;
+        --_openCount;
+    }
+    conn.state = CLOSED;
+    settle(conn);
+    if (_options.scenario == "churn" && running) {
+        // 接続できなかった場合は、すぐに接続し直して失敗を繰り返さないよう間を置く
+        if (connectFailed) {
+            conn.retryAt = nowNanos() + kRetryDelayNanos;
+        }
+        _restartQueue.push_back(static_cast<size_t>(&conn - &_connections[0]));
+    }
+}
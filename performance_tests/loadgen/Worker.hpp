@@ -0,0 +1,109 @@
+#ifndef WORKER_HPP
+#define WORKER_HPP
+
+#include "Options.hpp"
+#include "Stats.hpp"
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// 全ワーカーで共有する進行状態 (main スレッドが phase を進める)
+enum Phase { PHASE_SETUP, PHASE_MEASURE, PHASE_STOP };
+
+struct Control {
+    std::atomic<int> phase;
+    std::atomic<int> settled; // 登録・JOIN が完了 or 失敗した接続の数
+    std::atomic<int> active;  // 登録・JOIN を終えて、いま ACTIVE な接続の数
+    std::atomic<uint64_t> messagesSent;
+    std::atomic<uint64_t> messagesReceived;
+
+    Control() : phase(PHASE_SETUP), settled(0), active(0), messagesSent(0), messagesReceived(0) {}
+};
+
+// モノトニック時計の現在時刻 (ナノ秒)
+uint64_t nowNanos();
+
+/**
+ * @brief 1スレッド分の接続を epoll で駆動する
+ *
+ * 各接続は CONNECTING -> REGISTERING -> JOINING -> ACTIVE と進み、
+ * PHASE_MEASURE の間だけタイムスタンプ付きの PRIVMSG を送る。
+ * churn では ACTIVE にならずに QUITTING へ進み、切断されたら接続し直す。
+ */
+class Worker {
+  public:
+    Worker(const Options &options, Control &control, int firstClient, int clientCount);
+    ~Worker();
+
+    void run();
+    const Stats &getStats() const { return _stats; }
+
+  private:
+    enum State { IDLE, CONNECTING, REGISTERING, JOINING, ACTIVE, QUITTING, CLOSED };
+
+    struct Connection {
+        int fd;
+        int id;
+        State state;
+        bool settled;
+        bool writeWanted;
+        std::string in;
+        std::string out;
+        size_t outOffset;
+        uint64_t connectStart;
+        uint64_t registeredAt;
+        uint64_t quitSentAt;
+        uint64_t retryAt; // churn: これより前には接続し直さない
+        int joinsPending;
+        size_t nextTarget;
+        std::vector<std::string> targets;
+
+        Connection();
+    };
+
+    void startConnections(uint64_t now);
+    void startConnection(Connection &conn, uint64_t now);
+    void restartConnections(uint64_t now);
+    void failConnection(Connection &conn, uint64_t now);
+    void checkSetupTimeouts(uint64_t now);
+    void sendMessages(uint64_t now);
+    void sendQuitAll();
+
+    void handleEvent(Connection &conn, uint32_t events);
+    void handleConnected(Connection &conn);
+    void handleReadable(Connection &conn);
+    void processLines(Connection &conn);
+    void handleLine(Connection &conn, const std::string &line);
+    void handleNumeric(Connection &conn, int code);
+    void becomeReady(Connection &conn, uint64_t now);
+    void handlePrivmsg(const std::string &line, size_t textStart);
+
+    void queue(Connection &conn, const std::string &line);
+    void flush(Connection &conn);
+    void updateEvents(Connection &conn);
+    void settle(Connection &conn);
+    void closeConnection(Connection &conn, bool unexpected);
+
+    std::string nickFor(int id) const;
+    std::string channelFor(int index) const;
+
+    const Options &_options;
+    Control &_control;
+    Stats _stats;
+    int _epollFd;
+    std::vector<Connection> _connections;
+    size_t _nextToStart;
+    size_t _openCount;
+    size_t _activeCount;
+    size_t _nextSender;
+    uint64_t _startTime;
+    uint64_t _lastSendTick;
+    double _owedMessages;
+    uint64_t _sequence;
+    std::vector<char> _readBuffer;
+    std::vector<size_t> _restartQueue;
+    std::vector<size_t> _restartDue;
+};
+
+#endif
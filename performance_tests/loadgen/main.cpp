@@ -0,0 +1,137 @@
+#include "Options.hpp"
+#include "Stats.hpp"
+#include "Worker.hpp"
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// 1秒ごとの進捗表示
+static void printProgress(const char *phase, const Control &control, int clients,
+                          uint64_t &lastSent, uint64_t &lastReceived) {
+    uint64_t sent = control.messagesSent.load(std::memory_order_relaxed);
+    uint64_t received = control.messagesReceived.load(std::memory_order_relaxed);
+    std::cout << "[" << phase << "] settled " << control.settled.load() << "/" << clients
+              << "  sent/s " << (sent - lastSent) << "  recv/s " << (received - lastReceived)
+              << std::endl;
+    lastSent = sent;
+    lastReceived = received;
+}
+
+// /proc/<pid>/stat の utime + stime (クロックティック)。読めなければ -1
+static long serverCpuTicks(int pid) {
+    std::ostringstream path;
+    path << "/proc/" << pid << "/stat";
+    std::ifstream ifs(path.str().c_str());
+    std::string content;
+    if (!pid || !std::getline(ifs, content)) {
+        return -1;
+    }
+    // comm (2番目の項目) は空白を含みうるので ')' の後ろから数える
+    std::istringstream fields(content.substr(content.rfind(')') + 2));
+    std::string field;
+    long utime = 0;
+    long stime = 0;
+    for (int i = 3; i <= 15 && fields >> field; ++i) {
+        if (i == 14) {
+            utime = std::atol(field.c_str());
+        } else if (i == 15) {
+            stime = std::atol(field.c_str());
+        }
+    }
+    return utime + stime;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    // 切断済みソケットへの send() でプロセスが落ちないようにする
+    std::signal(SIGPIPE, SIG_IGN);
+
+    Control control;
+    std::vector<Worker *> workers;
+    int first = 0;
+    for (int i = 0; i < options.threads; ++i) {
+        int count = options.clients / options.threads + (i < options.clients % options.threads);
+        workers.push_back(new Worker(options, control, first, count));
+        first += count;
+    }
+    // churn は準備段階がなく、最初から計測する
+    if (options.scenario == "churn") {
+        control.phase.store(PHASE_MEASURE);
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < workers.size(); ++i) {
+        threads.push_back(std::thread(&Worker::run, workers[i]));
+    }
+
+    // 1. 全接続の登録・JOIN が終わる (または失敗する) まで待つ
+    double rampLimit = options.setupTimeout + 5.0;
+    if (options.connectRate > 0) {
+        rampLimit += options.clients / options.connectRate;
+    }
+    uint64_t lastSent = 0;
+    uint64_t lastReceived = 0;
+    uint64_t rampStart = nowNanos();
+    for (int tick = 1; options.scenario != "churn" && control.settled.load() < options.clients &&
+                       static_cast<double>(nowNanos() - rampStart) / 1e9 < rampLimit;
+         ++tick) {
+        usleep(100000);
+        if (!options.quiet && tick % 10 == 0) {
+            printProgress("setup", control, options.clients, lastSent, lastReceived);
+        }
+    }
+
+    // --hold: 接続を保ったまま、呼び出し側 (memory_bench.py) が標準入力を閉じるまで待つ。
+    // settled には失敗した接続も含まれるため、ready には ACTIVE な接続の数を出す
+    if (options.hold) {
+        std::cout << "ready " << control.active.load() << "/" << options.clients << std::endl;
+        std::string line;
+        while (std::getline(std::cin, line)) {
+        }
+    }
+
+    // 2. 計測 (PRIVMSG の送信)
+    long cpuStart = serverCpuTicks(options.serverPid);
+    uint64_t measureStart = nowNanos();
+    control.phase.store(PHASE_MEASURE);
+    for (int second = 0; second < static_cast<int>(options.duration); ++second) {
+        sleep(1);
+        if (!options.quiet) {
+            printProgress("measure", control, options.clients, lastSent, lastReceived);
+        }
+    }
+    double rest = options.duration - static_cast<int>(options.duration);
+    if (rest > 0) {
+        usleep(static_cast<useconds_t>(rest * 1e6));
+    }
+    double measuredSeconds = static_cast<double>(nowNanos() - measureStart) / 1e9;
+    long cpuEnd = serverCpuTicks(options.serverPid);
+
+    // 3. QUIT して終了
+    control.phase.store(PHASE_STOP);
+    Stats total;
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+        total.merge(workers[i]->getStats());
+        delete workers[i];
+    }
+    if (cpuStart >= 0 && cpuEnd >= cpuStart) {
+        double cpuSeconds = static_cast<double>(cpuEnd - cpuStart) / sysconf(_SC_CLK_TCK);
+        total.serverCpuPercent = cpuSeconds / measuredSeconds * 100.0;
+    }
+
+    printReport(options, total, measuredSeconds);
+    if (!options.jsonPath.empty() && !writeJsonReport(options.jsonPath, options, total,
+                                                      measuredSeconds)) {
+        return 1;
+    }
+    return total.connectOk == 0 ? 1 : 0;
+}
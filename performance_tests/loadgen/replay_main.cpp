@@ -0,0 +1,97 @@
+#include "Capture.hpp"
+#include "Replayer.hpp"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void printUsage(const char *program) {
+    ReplayOptions d;
+    std::cerr
+        << "Usage: " << program << " --file CAPTURE.irccap [options]\n"
+        << "  --file PATH          capture written by capture_proxy.py\n"
+        << "  --host HOST          server address (" << d.host << ")\n"
+        << "  --port PORT          server port (" << d.port << ")\n"
+        << "  --password PASS      replace the argument of captured PASS lines\n"
+        << "  --mode MODE          paced (captured timing) | max (as fast as possible) ("
+        << d.mode << ")\n"
+        << "  --speed X            paced: playback speed multiplier (" << d.speed << ")\n"
+        << "  --drain S            wait S seconds of silence before closing a session ("
+        << d.drain << ")\n"
+        << "  --json PATH          write the report as JSON\n";
+}
+
+static bool parseReplayOptions(int argc, char **argv, ReplayOptions &o) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+        const char *value = argv[++i];
+        if (arg == "--file") {
+            o.file = value;
+        } else if (arg == "--host") {
+            o.host = value;
+        } else if (arg == "--port") {
+            o.port = std::atoi(value);
+        } else if (arg == "--password") {
+            o.password = value;
+        } else if (arg == "--mode") {
+            o.mode = value;
+        } else if (arg == "--speed") {
+            o.speed = std::atof(value);
+        } else if (arg == "--drain") {
+            o.drain = std::atof(value);
+        } else if (arg == "--json") {
+            o.jsonPath = value;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if (o.file.empty() || (o.mode != "paced" && o.mode != "max") || o.speed <= 0 ||
+        o.port <= 0 || o.drain < 0) {
+        std::cerr << "Invalid option values (check --file/--mode/--speed/--port)" << std::endl;
+        printUsage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    ReplayOptions options;
+    if (!parseReplayOptions(argc, argv, options)) {
+        return 1;
+    }
+    // 切断済みソケットへの send() でプロセスが落ちないようにする
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<CapturedSession> sessions;
+    std::string error;
+    if (!loadCapture(options.file, sessions, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    if (sessions.empty()) {
+        std::cerr << options.file << ": no sessions" << std::endl;
+        return 1;
+    }
+
+    Replayer replayer(options, sessions);
+    if (!replayer.run()) {
+        return 1;
+    }
+    replayer.printReport();
+    if (!options.jsonPath.empty() && !replayer.writeJsonReport(options.jsonPath)) {
+        return 1;
+    }
+    return 0;
+}
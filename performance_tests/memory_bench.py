@@ -0,0 +1,200 @@
+"""
+アイドル状態のクライアント・チャンネル・チャンネル参加 (membership) を一定数ずつ増やしながら
+サーバーのメモリ使用量を測り、1オブジェクトあたりのバイト数を最小二乗法で求めるベンチマーク。
+
+    python3 memory_bench.py --step 1000 --steps 10
+
+3種類の増やし方をそれぞれ新しいサーバーで実行する。
+  clients     : どのチャンネルにも入らないクライアント              -> client
+  channels    : 自分だけが入るチャンネルを1つ作るクライアント       -> client + channel + membership
+  memberships : 共有のチャンネル群のうち K 個に入るクライアント     -> client + K * membership
+IRC では空のチャンネルは作れないため、channel のコストは差し引きで求める。
+"""
+import argparse
+import json
+import os
+import subprocess
+import time
+
+from server_runner import (IRCServerProcess, LOADGEN, SERVER_EXECUTABLE, SERVER_PASSWORD,
+                           SERVER_PORT, build_loadgen, raise_fd_limit, source_addrs_for)
+
+# smaps_rollup / status から記録する項目 (KiB)
+MEMORY_FIELDS = ("Rss", "Anonymous", "Private_Dirty")
+
+
+class HeldClients:
+    """irc_loadgen --hold で接続を張り、標準入力を閉じるまで保持させる。"""
+    def __init__(self, args):
+        build_loadgen()
+        command = [LOADGEN, "--hold", "--quiet"] + [str(arg) for arg in args]
+        self.process = subprocess.Popen(command, stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                        text=True)
+
+    def wait_ready(self):
+        """"ready <active>/<clients>" を待ち、登録・JOIN を終えた接続数を返す。"""
+        for line in self.process.stdout:
+            if line.startswith("ready "):
+                return int(line.split()[1].split("/")[0])
+        raise RuntimeError("irc_loadgen exited before the clients were ready")
+
+    def release(self):
+        """標準入力を閉じて QUIT させる。終了は wait() で待つ。"""
+        self.process.stdin.close()
+
+    def wait(self):
+        self.process.stdout.read()
+        self.process.wait(timeout=60)
+
+
+def sample(server):
+    """サーバーのメモリ使用量を1回分読む。"""
+    rollup = server.smaps_rollup()
+    status = server.proc_status()
+    result = {key.lower(): rollup.get(key, -1) for key in MEMORY_FIELDS}
+    result["vm_data"] = status.get("VmData", -1)
+    result["fds"] = server.fd_count()
+    return result
+
+
+def linear_fit(xs, ys):
+    """y = slope * x + intercept の最小二乗当てはめ。r2 も返す。"""
+    n = len(xs)
+    if n < 2:
+        return {"slope": 0.0, "intercept": ys[0] if ys else 0.0, "r2": 0.0}
+    mean_x = sum(xs) / n
+    mean_y = sum(ys) / n
+    sxx = sum((x - mean_x) ** 2 for x in xs)
+    sxy = sum((x - mean_x) * (y - mean_y) for x, y in zip(xs, ys))
+    syy = sum((y - mean_y) ** 2 for y in ys)
+    slope = sxy / sxx if sxx else 0.0
+    r2 = (sxy * sxy) / (sxx * syy) if sxx and syy else 0.0
+    return {"slope": slope, "intercept": mean_y - slope * mean_x, "r2": r2}
+
+
+def batch_args(args, sweep, index):
+    """sweep の index 番目のバッチ用の irc_loadgen 引数。ニックネームはバッチごとに分ける。"""
+    common = [
+        "--port", args.port,
+        "--password", args.password,
+        "--clients", args.step,
+        "--threads", args.threads,
+        "--connect-rate", args.connect_rate,
+        "--setup-timeout", 120,
+        "--source-addrs", source_addrs_for(args.step * args.steps),
+        "--nick-prefix", f"{sweep[0]}{index}_",
+    ]
+    if sweep == "clients":
+        return common + ["--channels", 0, "--joins", 0]
+    if sweep == "channels":
+        # 各クライアントが自分専用のチャンネル #c<index>_<id> に1人で入る
+        return common + ["--channels", args.step, "--joins", 1,
+                         "--channel-prefix", f"c{index}_"]
+    # memberships: 全バッチ共通のチャンネル群に K 個ずつ参加する。
+    # チャンネル数を多めにして1チャンネルの人数 (= JOIN 通知の数) を抑える
+    return common + ["--channels", args.membership_channels, "--joins", args.joins,
+                     "--channel-prefix", "m"]
+
+
+def run_sweep(args, sweep):
+    """新しいサーバーで sweep を1つ実行し、ステップごとの計測値と当てはめ結果を返す。"""
+    steps = []
+    batches = []
+    total_ready = 0
+    with IRCServerProcess(args.server, args.port, args.password) as server:
+        baseline = sample(server)
+        try:
+            for index in range(args.steps):
+                batch = HeldClients(batch_args(args, sweep, index))
+                batches.append(batch)
+                ready = batch.wait_ready()
+                total_ready += ready
+                time.sleep(args.settle)
+                point = sample(server)
+                # x には実際に ACTIVE になった接続の累計を使う
+                point["clients"] = total_ready
+                point["short"] = ready != args.step
+                steps.append(point)
+                print(f"{sweep:>12} {point['clients']:>8} clients  "
+                      f"rss {point['rss']:>8} kB  anon {point['anonymous']:>8} kB")
+                if point["short"]:
+                    # 一部の接続が失敗したステップは、サーバーが上限に達している可能性があるため
+                    # 当てはめから外し、この sweep を打ち切る
+                    print(f"WARNING: {sweep} step {index}: only {ready}/{args.step} clients ready, "
+                          f"stopping this sweep")
+                    break
+        finally:
+            for batch in batches:
+                batch.release()
+            for batch in batches:
+                batch.wait()
+    # 最初のバッチで作られるチャンネル群などの固定費は切片に入る
+    fitted = [point for point in steps if not point["short"]]
+    xs = [point["clients"] for point in fitted]
+    fits = {key: linear_fit(xs, [point[key] * 1024 for point in fitted])
+            for key in ("rss", "anonymous")}
+    return {"baseline": baseline, "steps": steps, "fit_bytes_per_client": fits}
+
+
+def per_object_costs(sweeps, joins):
+    """各 sweep の傾き (バイト/クライアント) から client / channel / membership のコストを解く。"""
+    costs = {}
+    for key in ("rss", "anonymous"):
+        client = sweeps["clients"]["fit_bytes_per_client"][key]["slope"]
+        membership = (sweeps["memberships"]["fit_bytes_per_client"][key]["slope"] - client) / joins
+        channel = sweeps["channels"]["fit_bytes_per_client"][key]["slope"] - client - membership
+        costs[key] = {"client": round(client), "channel": round(channel),
+                      "membership": round(membership)}
+    return costs
+
+
+def print_summary(costs, sweeps):
+    print("\n=== memory footprint (bytes per object) ===")
+    print(f"{'metric':<10} {'client':>10} {'channel':>10} {'membership':>11}")
+    for key, cost in costs.items():
+        print(f"{key:<10} {cost['client']:>10} {cost['channel']:>10} {cost['membership']:>11}")
+    for name, sweep in sweeps.items():
+        fit = sweep["fit_bytes_per_client"]["anonymous"]
+        print(f"{name:<12} anon slope {fit['slope']:>9.0f} B/client  r2 {fit['r2']:.3f}")
+    print("(anonymous = heap and other anonymous mappings from /proc/<pid>/smaps_rollup)")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Memory footprint benchmark")
+    parser.add_argument("--step", type=int, default=1000, help="clients added per step")
+    parser.add_argument("--steps", type=int, default=10)
+    parser.add_argument("--joins", type=int, default=10,
+                        help="channels joined by each client in the memberships sweep")
+    parser.add_argument("--membership-channels", type=int, default=1000,
+                        help="size of the shared channel pool in the memberships sweep")
+    parser.add_argument("--settle", type=float, default=0.5,
+                        help="seconds to wait after a step before sampling")
+    parser.add_argument("--threads", type=int, default=os.cpu_count() or 4)
+    parser.add_argument("--connect-rate", type=float, default=5000.0)
+    parser.add_argument("--server", default=SERVER_EXECUTABLE)
+    parser.add_argument("--port", type=int, default=SERVER_PORT)
+    parser.add_argument("--password", default=SERVER_PASSWORD)
+    parser.add_argument("--output", default="memory_result.json")
+    args = parser.parse_args()
+
+    limit = raise_fd_limit()
+    if args.step * args.steps + 64 > limit:
+        parser.error(f"{args.step * args.steps} clients exceed the fd limit {limit}")
+
+    sweeps = {}
+    for sweep in ("clients", "channels", "memberships"):
+        sweeps[sweep] = run_sweep(args, sweep)
+    costs = per_object_costs(sweeps, args.joins)
+
+    print_summary(costs, sweeps)
+    with open(args.output, "w") as f:
+        json.dump({"benchmark": "memory",
+                   "config": {"step": args.step, "steps": args.steps, "joins": args.joins,
+                              "membership_channels": args.membership_channels},
+                   "bytes_per_object": costs,
+                   "sweeps": sweeps}, f, indent=2)
+    print(f"Saved {args.output}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,231 @@
+"""
+マイクロベンチマーク (unit_tests/ft_irc_bench) と負荷シナリオ (irc_loadgen) を実行し、
+コミット済みのベースライン (perf_baseline.json) と比べて性能の劣化を検出するゲート。
+許容幅を超えて悪化した指標があれば差分の表を表示して終了コード 1 で終わる。
+
+    python3 perf_gate.py                    # 計測してベースラインと比較
+    python3 perf_gate.py --update-baseline  # 計測結果をベースラインとして保存
+"""
+import argparse
+import fnmatch
+import json
+import math
+import os
+import subprocess
+import sys
+import tempfile
+
+from server_runner import (IRCServerProcess, PERF_DIR, SERVER_EXECUTABLE, SERVER_PASSWORD,
+                           SERVER_PORT, raise_fd_limit, run_loadgen)
+
+UNIT_TESTS_DIR = os.path.join(PERF_DIR, "..", "unit_tests")
+BENCH_BINARY = os.path.join(UNIT_TESTS_DIR, "ft_irc_bench")
+BASELINE_PATH = os.path.join(PERF_DIR, "perf_baseline.json")
+
+# 比較の再現性のため、負荷シナリオの設定はゲート側で固定する (ベースラインにも記録される)
+LOAD_CONFIG = {"clients": 500, "channels": 10, "joins": 2, "msg_rate": 10, "duration": 10}
+CHURN_CONFIG = {"clients": 50, "duration": 10}
+
+# google benchmark の time_unit をナノ秒に直す係数
+TIME_UNIT_NS = {"ns": 1, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def run_microbenchmarks(args):
+    """ft_irc_bench を繰り返し実行し、各ベンチマークの中央値 (ns) を返す。"""
+    subprocess.run(["make", "-C", UNIT_TESTS_DIR, "ft_irc_bench"], check=True)
+    metrics = {}
+    with tempfile.TemporaryDirectory() as tmp:
+        json_path = os.path.join(tmp, "bench.json")
+        subprocess.run([BENCH_BINARY,
+                        f"--benchmark_repetitions={args.repetitions}",
+                        "--benchmark_report_aggregates_only=true",
+                        f"--benchmark_out={json_path}",
+                        "--benchmark_out_format=json"], check=True)
+        with open(json_path) as f:
+            report = json.load(f)
+    for bench in report.get("benchmarks", []):
+        if bench.get("aggregate_name", "median") != "median":
+            continue
+        name = bench.get("run_name", bench["name"])
+        scale = TIME_UNIT_NS.get(bench.get("time_unit", "ns"), 1)
+        metrics[f"bench/{name}"] = {"value": bench["real_time"] * scale, "better": "lower"}
+    return metrics
+
+
+def run_load_scenarios(args):
+    """load と churn シナリオを新しいサーバーでそれぞれ実行し、主要な指標を返す。"""
+    metrics = {}
+    with tempfile.TemporaryDirectory() as tmp:
+        json_path = os.path.join(tmp, "load.json")
+        with IRCServerProcess(args.server, args.port, args.password) as server:
+            report = run_loadgen([
+                "--port", args.port, "--password", args.password,
+                "--clients", LOAD_CONFIG["clients"],
+                "--channels", LOAD_CONFIG["channels"],
+                "--joins", LOAD_CONFIG["joins"],
+                "--msg-rate", LOAD_CONFIG["msg_rate"],
+                "--duration", LOAD_CONFIG["duration"],
+                "--server-pid", server.pid, "--quiet",
+            ], json_path)
+        counters = report["counters"]
+        latency = report["latency_us"]
+        metrics["load/received_per_s"] = {
+            "value": report["throughput"]["messages_received_per_s"], "better": "higher"}
+        for phase, quantile in (("register", "p99"), ("delivery", "p50"), ("delivery", "p99")):
+            metrics[f"load/{phase}_{quantile}_us"] = {
+                "value": latency[phase][quantile], "better": "lower"}
+        metrics["load/server_cpu_percent"] = {
+            "value": report.get("server_cpu_percent", 0), "better": "lower"}
+        metrics["load/errors"] = {
+            "value": sum(counters[key] for key in ("connect_errors", "register_errors",
+                                                   "setup_timeouts", "join_errors",
+                                                   "disconnects", "error_replies")),
+            "better": "lower"}
+
+        with IRCServerProcess(args.server, args.port, args.password):
+            report = run_loadgen([
+                "--scenario", "churn",
+                "--port", args.port, "--password", args.password,
+                "--clients", CHURN_CONFIG["clients"],
+                "--connect-rate", CHURN_CONFIG["clients"] * 10,
+                "--duration", CHURN_CONFIG["duration"], "--quiet",
+            ], json_path)
+        metrics["churn/cycles_per_s"] = {
+            "value": report["throughput"]["cycles_per_s"], "better": "higher"}
+        metrics["churn/cycle_p99_us"] = {
+            "value": report["latency_us"]["cycle"]["p99"], "better": "lower"}
+    return metrics
+
+
+def tolerance_for(name, rules):
+    """rules (パターンと許容幅の組) のうち最初に一致したものの許容幅を返す。"""
+    for rule in rules:
+        if fnmatch.fnmatch(name, rule["pattern"]):
+            return rule["tolerance"]
+    return 0.10
+
+
+def compare(baseline, current):
+    """指標ごとに (名前, 基準値, 今回値, 変化率, 許容幅, 判定) の行を作る。"""
+    rows = []
+    rules = baseline.get("tolerances", [])
+    for name in sorted(set(baseline["metrics"]) | set(current)):
+        base = baseline["metrics"].get(name)
+        cur = current.get(name)
+        if base is None:
+            rows.append((name, None, cur["value"], None, None, "new"))
+            continue
+        if cur is None:
+            rows.append((name, base["value"], None, None, None, "missing"))
+            continue
+        tolerance = tolerance_for(name, rules)
+        if base["value"] == 0:
+            change = 0.0 if cur["value"] == 0 else math.copysign(math.inf, cur["value"])
+        else:
+            change = (cur["value"] - base["value"]) / abs(base["value"])
+        # 「悪くなった方向」への変化率に揃えて許容幅と比べる
+        worse = change if base["better"] == "lower" else -change
+        if worse > tolerance:
+            status = "REGRESSION"
+        elif worse < -tolerance:
+            status = "improved"
+        else:
+            status = "ok"
+        rows.append((name, base["value"], cur["value"], change, tolerance, status))
+    return rows
+
+
+def format_value(value):
+    if value is None:
+        return "-"
+    return f"{value:.1f}" if abs(value) < 1e6 else f"{value:.3e}"
+
+
+def print_table(rows):
+    width = max([len(row[0]) for row in rows] + [6])
+    print(f"\n{'metric':<{width}} {'baseline':>12} {'current':>12} {'change':>9} "
+          f"{'tol':>6}  status")
+    for name, base, cur, change, tolerance, status in rows:
+        change_text = "-" if change is None else (
+            "inf" if math.isinf(change) else f"{change * 100:+.1f}%")
+        tolerance_text = "-" if tolerance is None else f"{tolerance * 100:.0f}%"
+        print(f"{name:<{width}} {format_value(base):>12} {format_value(cur):>12} "
+              f"{change_text:>9} {tolerance_text:>6}  {status}")
+
+
+def load_baseline(path):
+    with open(path) as f:
+        return json.load(f)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Performance regression gate")
+    parser.add_argument("--baseline", default=BASELINE_PATH)
+    parser.add_argument("--update-baseline", action="store_true",
+                        help="store this run's results as the new baseline")
+    parser.add_argument("--skip-bench", action="store_true", help="skip ft_irc_bench")
+    parser.add_argument("--skip-load", action="store_true", help="skip the load scenarios")
+    parser.add_argument("--repetitions", type=int, default=5)
+    parser.add_argument("--server", default=SERVER_EXECUTABLE)
+    parser.add_argument("--port", type=int, default=SERVER_PORT)
+    parser.add_argument("--password", default=SERVER_PASSWORD)
+    parser.add_argument("--output", default="perf_gate_result.json")
+    args = parser.parse_args()
+
+    raise_fd_limit()
+    baseline = load_baseline(args.baseline)
+    # 比べる相手がなければ判定できないので、計測する前に失敗させる
+    if not baseline["metrics"] and not args.update_baseline:
+        print(f"Baseline {args.baseline} has no metrics yet. "
+              "Record one with --update-baseline and commit it.")
+        return 1
+    config = {"load": LOAD_CONFIG, "churn": CHURN_CONFIG, "repetitions": args.repetitions}
+    if baseline.get("config") and baseline["config"] != config:
+        print("WARNING: baseline was recorded with a different configuration:")
+        print(f"  baseline {baseline['config']}\n  current  {config}")
+
+    current = {}
+    if not args.skip_bench:
+        current.update(run_microbenchmarks(args))
+    if not args.skip_load:
+        current.update(run_load_scenarios(args))
+    with open(args.output, "w") as f:
+        json.dump({"config": config, "metrics": current}, f, indent=2)
+
+    measured = () if args.skip_bench else ("bench/",)
+    measured += () if args.skip_load else ("load/", "churn/")
+
+    if args.update_baseline:
+        # 今回計測した側の指標だけを置き換え、スキップした側の記録は残す
+        metrics = {name: value for name, value in baseline["metrics"].items()
+                   if not name.startswith(measured)}
+        metrics.update(current)
+        baseline["config"] = config
+        baseline["metrics"] = metrics
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=2)
+            f.write("\n")
+        print(f"Baseline updated: {args.baseline} ({len(current)} metrics measured, "
+              f"{len(metrics)} in total)")
+        return 0
+
+    # スキップした側の指標は「missing」として扱わない
+    baseline["metrics"] = {name: value for name, value in baseline["metrics"].items()
+                           if name.startswith(measured)}
+
+    rows = compare(baseline, current)
+    print_table(rows)
+    regressions = [row for row in rows if row[5] in ("REGRESSION", "missing")]
+    if not baseline["metrics"]:
+        print("\nFAILED: the baseline has no metrics for the scenarios that were run. "
+              "Record them with --update-baseline and commit it.")
+        return 1
+    if regressions:
+        print(f"\nFAILED: {len(regressions)} metric(s) regressed beyond tolerance")
+        return 1
+    print("\nOK: no regressions")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,146 @@
+"""ベンチマーク用に ircserv と irc_loadgen を起動し、/proc からサーバーの使用リソースを読むモジュール。"""
+import json
+import os
+import resource
+import subprocess
+import time
+
+# --- サーバー設定 (integration_tests/conftest.py と同じ起動方法) ---
+SERVER_EXECUTABLE = "../../ircserv"
+SERVER_PORT = 6669
+SERVER_PASSWORD = "testpass"
+SERVER_HOST = "127.0.0.1"
+
+PERF_DIR = os.path.dirname(os.path.abspath(__file__))
+LOADGEN_DIR = os.path.join(PERF_DIR, "loadgen")
+LOADGEN = os.path.join(LOADGEN_DIR, "irc_loadgen")
+
+
+class IRCServerProcess:
+    """
+    ircserv をサブプロセスとして起動・停止するヘルパークラス。
+    大量のログでパイプが詰まってサーバーが止まらないよう、標準出力はファイルか /dev/null に捨てる。
+    """
+    def __init__(self, executable=SERVER_EXECUTABLE, port=SERVER_PORT,
+                 password=SERVER_PASSWORD, log_path=None):
+        self.executable = executable
+        self.port = port
+        self.password = password
+        self.log_path = log_path
+        self.process = None
+        self._log = None
+
+    def start(self):
+        """サーバーを起動し、起動に失敗していないことを確認する。"""
+        print(f"Starting ircserv on {SERVER_HOST}:{self.port}...")
+        if self.log_path:
+            self._log = open(self.log_path, "w")
+        output = self._log if self._log else subprocess.DEVNULL
+        self.process = subprocess.Popen(
+            [self.executable, str(self.port), self.password],
+            stdout=output,
+            stderr=subprocess.STDOUT,
+        )
+        # サーバーが起動するのを待つ
+        time.sleep(0.3)
+        if self.process.poll() is not None:
+            raise RuntimeError(f"サーバーの起動に失敗しました (exit code {self.process.returncode})")
+        return self
+
+    def stop(self):
+        """サーバーを停止する。時間内に終了しなければ強制終了する。"""
+        if self.process is None:
+            return
+        print("Shutting down ircserv...")
+        self.process.terminate()
+        try:
+            self.process.wait(timeout=5.0)
+        except subprocess.TimeoutExpired:
+            print("サーバーが時間内に終了しなかったため、強制終了します。")
+            self.process.kill()
+            self.process.wait()
+        if self._log:
+            self._log.close()
+            self._log = None
+
+    @property
+    def pid(self):
+        return self.process.pid
+
+    def cpu_seconds(self):
+        """サーバーが消費した CPU 時間 (user + system, 秒)。"""
+        with open(f"/proc/{self.pid}/stat") as f:
+            fields = f.read().rsplit(")", 1)[1].split()
+        # ')' の後ろは3番目の項目 (state) から始まる。utime=14, stime=15
+        ticks = int(fields[14 - 3]) + int(fields[15 - 3])
+        return ticks / os.sysconf("SC_CLK_TCK")
+
+    def rss_kb(self):
+        """サーバーの常駐メモリ (VmRSS, KiB)。"""
+        return self.proc_status().get("VmRSS", 0)
+
+    def proc_status(self):
+        """/proc/<pid>/status のうち kB 単位の項目を辞書で返す。"""
+        status = {}
+        with open(f"/proc/{self.pid}/status") as f:
+            for line in f:
+                key, _, value = line.partition(":")
+                parts = value.split()
+                if len(parts) == 2 and parts[1] == "kB":
+                    status[key] = int(parts[0])
+        return status
+
+    def smaps_rollup(self):
+        """/proc/<pid>/smaps_rollup の集計値 (KiB)。Anonymous がヒープの目安になる。"""
+        rollup = {}
+        try:
+            with open(f"/proc/{self.pid}/smaps_rollup") as f:
+                for line in f:
+                    key, _, value = line.partition(":")
+                    parts = value.split()
+                    if len(parts) == 2 and parts[1] == "kB":
+                        rollup[key] = int(parts[0])
+        except FileNotFoundError:
+            pass
+        return rollup
+
+    def fd_count(self):
+        """サーバーが開いているファイルディスクリプタの数。"""
+        return len(os.listdir(f"/proc/{self.pid}/fd"))
+
+    def __enter__(self):
+        return self.start()
+
+    def __exit__(self, exc_type, exc, tb):
+        self.stop()
+
+
+def raise_fd_limit():
+    """
+    大量の接続を張れるように、このプロセス (と子プロセス) の fd 上限をハードリミットまで上げる。
+    """
+    soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+    if soft < hard:
+        resource.setrlimit(resource.RLIMIT_NOFILE, (hard, hard))
+    return resource.getrlimit(resource.RLIMIT_NOFILE)[0]
+
+
+def build_loadgen():
+    """irc_loadgen が無ければビルドする。"""
+    if not os.path.exists(LOADGEN):
+        subprocess.run(["make", "-C", LOADGEN_DIR], check=True)
+
+
+def source_addrs_for(clients):
+    """1つの送信元アドレスのエフェメラルポート (約28000) に収まるよう、使うアドレス数を決める。"""
+    return clients // 20000 + 1
+
+
+def run_loadgen(args, json_path):
+    """irc_loadgen を実行し、JSON レポートを辞書で返す。"""
+    build_loadgen()
+    command = [LOADGEN, "--json", json_path] + [str(arg) for arg in args]
+    print("$ " + " ".join(command))
+    subprocess.run(command, check=False)
+    with open(json_path) as f:
+        return json.load(f)
@@ -0,0 +1,109 @@
+"""
+キャプチャファイル (.irccap) の読み書き。capture_proxy.py が書き、loadgen/irc_replay が読む。
+
+フォーマット (整数はすべて LEB128 の可変長符号なし整数):
+    ヘッダ   : b"IRCCAP01"
+    レコード : type (1 byte) | session | dt_us | [LINE のみ: len | bytes]
+      type    1 = OPEN   クライアントが接続した
+              2 = LINE   クライアント -> サーバーの1行 (末尾の CRLF は含めない)
+              3 = REPLY  サーバー -> クライアントの1行 (本文は記録せず、数だけ数える)
+              4 = CLOSE  接続が閉じた
+      session 接続ごとの通し番号 (0 から)
+      dt_us   直前のレコードからの経過時間 (マイクロ秒)
+
+    python3 trafficlog.py capture.irccap   # 中身の要約を表示
+"""
+import sys
+import time
+
+MAGIC = b"IRCCAP01"
+OPEN, LINE, REPLY, CLOSE = 1, 2, 3, 4
+TYPE_NAMES = {OPEN: "OPEN", LINE: "LINE", REPLY: "REPLY", CLOSE: "CLOSE"}
+
+
+def encode_varint(value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+class TrafficWriter:
+    """レコードを時刻順にファイルへ追記する。"""
+    def __init__(self, path):
+        self._file = open(path, "wb")
+        self._file.write(MAGIC)
+        self._last_us = None
+
+    def write(self, record_type, session, payload=b""):
+        now_us = time.monotonic_ns() // 1000
+        dt_us = 0 if self._last_us is None else now_us - self._last_us
+        self._last_us = now_us
+        record = bytes([record_type]) + encode_varint(session) + encode_varint(dt_us)
+        if record_type == LINE:
+            record += encode_varint(len(payload)) + payload
+        self._file.write(record)
+
+    def close(self):
+        self._file.close()
+
+
+def read_records(path):
+    """(type, session, t_us, payload) を順に返す。t_us はキャプチャ開始からの時刻。"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if not data.startswith(MAGIC):
+        raise ValueError(f"{path}: not an irccap file")
+    pos = len(MAGIC)
+
+    def varint():
+        nonlocal pos
+        value = shift = 0
+        while True:
+            byte = data[pos]
+            pos += 1
+            value |= (byte & 0x7F) << shift
+            if byte < 0x80:
+                return value
+            shift += 7
+
+    t_us = 0
+    while pos < len(data):
+        record_type = data[pos]
+        pos += 1
+        session = varint()
+        t_us += varint()
+        payload = b""
+        if record_type == LINE:
+            length = varint()
+            payload = data[pos:pos + length]
+            pos += length
+        yield record_type, session, t_us, payload
+
+
+def summarize(path):
+    counts = {name: 0 for name in TYPE_NAMES.values()}
+    sessions = set()
+    commands = {}
+    end_us = 0
+    for record_type, session, t_us, payload in read_records(path):
+        name = TYPE_NAMES.get(record_type, "?")
+        counts[name] = counts.get(name, 0) + 1
+        sessions.add(session)
+        end_us = t_us
+        if record_type == LINE and payload:
+            command = payload.split(b" ", 1)[0].decode(errors="replace").upper()
+            commands[command] = commands.get(command, 0) + 1
+    print(f"{path}: {len(sessions)} sessions, {end_us / 1e6:.1f} s")
+    print("  " + ", ".join(f"{name} {count}" for name, count in counts.items()))
+    top = sorted(commands.items(), key=lambda item: -item[1])[:10]
+    print("  commands: " + ", ".join(f"{name} {count}" for name, count in top))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        print(f"Usage: {sys.argv[0]} FILE.irccap")
+        sys.exit(1)
+    summarize(sys.argv[1])
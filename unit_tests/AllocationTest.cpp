@@ -0,0 +1,138 @@
+#include "TestFixture.hpp"
+
+// 許容する割り当て回数の上限。ホットパスを最適化したら値を下げ、退行をここで検出する。
+// まだ実測していない上限は kAllocBudgetNotRecorded にしておき、テストは計測した回数を
+// "[ ALLOCS   ]" の行に表示するだけで検証しない。ircserv と合わせて実行し、表示された回数を書くこと。
+// (括弧内は実装から見積もった値で、実測の目安)
+static const std::size_t kPrivmsgAllocBudget = kAllocBudgetNotRecorded;    // parseAndExecute 1回あたり (24)
+static const std::size_t kBroadcastAllocBudget = kAllocBudgetNotRecorded;  // メンバー数によらず一定 (1)
+static const std::size_t kReadLineAllocBudget = kAllocBudgetNotRecorded;   // 1行あたり (1)
+static const std::size_t kSendBufferAllocBudget = kAllocBudgetNotRecorded; // append/remove 1回あたり (1)
+
+static const int kBroadcastSmall = 5;
+static const int kBroadcastLarge = 50;
+
+class AllocationTest : public CommandManagerTest {
+  protected:
+    virtual void SetUp() {
+        CommandManagerTest::SetUp();
+        registerClient(client1, "User1");
+        registerClient(client2, "User2");
+        // 受信メッセージの格納による割り当てを計測から外す
+        client1->receivedMessages.reserve(64);
+        client2->receivedMessages.reserve(64);
+    }
+
+    // members 人のチャンネルに1回 broadcast したときの割り当て回数を返す
+    std::size_t broadcastAllocations(const std::string &name, int members, int firstFd) {
+        Channel *channel = new Channel(name);
+        server->addChannel(channel);
+
+        std::vector<TestClient *> joined;
+        for (int i = 0; i < members; ++i) {
+            TestClient *member = new TestClient(firstFd + i, "member.host");
+            server->addTestClient(member);
+            member->receivedMessages.reserve(4);
+            channel->addMember(member);
+            joined.push_back(member);
+        }
+
+        // 短いメッセージは SSO に収まるため、TestClient 側のコピーでは割り当てが起きない
+        const std::string message = "Hi";
+        AllocationCounter counter;
+        channel->broadcast(message, NULL);
+        std::size_t allocations = counter.count();
+
+        for (std::size_t i = 0; i < joined.size(); ++i) {
+            EXPECT_EQ(joined[i]->getLastMessage(), message);
+        }
+        return allocations;
+    }
+};
+
+TEST_F(AllocationTest, ParseAndExecute_PrivmsgToUser) {
+    const std::string line = "PRIVMSG User2 :Hello there!";
+
+    // 初回実行で遅延初期化されるものを計測から外す
+    cmdManager->parseAndExecute(client1, line);
+    client2->receivedMessages.clear();
+
+    // TestClient がメッセージをコピーする1回分も上限に含む
+    EXPECT_ALLOCATIONS_AT_MOST(kPrivmsgAllocBudget, cmdManager->parseAndExecute(client1, line));
+    ASSERT_EQ(client2->receivedMessages.size(), static_cast<std::string::size_type>(1));
+}
+
+TEST_F(AllocationTest, ParseAndExecute_PrivmsgToChannel) {
+    Channel *channel = new Channel("#alloc");
+    server->addChannel(channel);
+    channel->addMember(client1);
+    channel->addMember(client2);
+    client1->addChannel(channel);
+    client2->addChannel(channel);
+
+    const std::string line = "PRIVMSG #alloc :Hello channel!";
+    cmdManager->parseAndExecute(client1, line);
+    client2->receivedMessages.clear();
+
+    EXPECT_ALLOCATIONS_AT_MOST(kPrivmsgAllocBudget, cmdManager->parseAndExecute(client1, line));
+    ASSERT_EQ(client2->receivedMessages.size(), static_cast<std::string::size_type>(1));
+}
+
+TEST_F(AllocationTest, Channel_BroadcastDoesNotScaleWithMembers) {
+    std::size_t small = broadcastAllocations("#narrow", kBroadcastSmall, 100);
+    std::size_t large = broadcastAllocations("#wide", kBroadcastLarge, 200);
+
+    // 割り当て回数がメンバー数に比例していないことを、2つのメンバー数で比べて確かめる
+    EXPECT_EQ(small, large) << kBroadcastSmall << " members: " << small << ", "
+                            << kBroadcastLarge << " members: " << large;
+    expectAllocationsWithin(kBroadcastAllocBudget, 1, large, "Channel::broadcast");
+}
+
+TEST_F(AllocationTest, Client_ReadBufferPath) {
+    std::string chunk;
+    for (int i = 0; i < 10; ++i) {
+        chunk += "PING :tok\r\n";
+    }
+
+    // バッファの容量を事前に確保させる
+    client1->appendBuffer(chunk);
+    while (!client1->readLineFromBuffer().empty()) {
+    }
+
+    AllocationCounter counter;
+    client1->appendBuffer(chunk);
+    std::size_t lines = 0;
+    while (client1->readLineFromBuffer() == "PING :tok") {
+        ++lines;
+    }
+    std::size_t allocations = counter.count();
+
+    ASSERT_EQ(lines, static_cast<std::size_t>(10));
+    expectAllocationsWithin(kReadLineAllocBudget, lines, allocations, "readLineFromBuffer");
+}
+
+TEST_F(AllocationTest, Client_SendBufferPath) {
+    const std::string reply = ":irc.myserver.com PONG irc.myserver.com :tok\r\n";
+
+    // バッファの容量を事前に確保させる
+    for (int i = 0; i < 10; ++i) {
+        client1->appendToSendBuffer(reply);
+    }
+    client1->removeSentData(client1->getSendBuffer().length());
+
+    AllocationCounter counter;
+    std::size_t operations = 0;
+    for (int i = 0; i < 10; ++i) {
+        client1->appendToSendBuffer(reply);
+        ++operations;
+    }
+    // 部分送信を模して少しずつ取り除く
+    while (!client1->getSendBuffer().empty()) {
+        client1->removeSentData(reply.length());
+        ++operations;
+    }
+    std::size_t allocations = counter.count();
+
+    expectAllocationsWithin(kSendBufferAllocBudget, operations, allocations,
+                            "appendToSendBuffer / removeSentData");
+}
@@ -0,0 +1,73 @@
+#ifndef BENCH_FIXTURE_HPP
+#define BENCH_FIXTURE_HPP
+
+#include "Channel.hpp"
+#include "Client.hpp"
+#include "CommandManager.hpp"
+#include "Replies.hpp"
+#include "Server.hpp"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+/**
+ * @brief Client::sendMessage をオーバーライドし、送信量だけを数えるクライアント
+ * (TestClient と違いメッセージを保存しないため、計測にコピーのコストが混ざらない)
+ */
+class BenchClient : public Client {
+  public:
+    mutable std::size_t sentMessages;
+    mutable std::size_t sentBytes;
+
+    BenchClient(int fd, const std::string &hostname)
+        : Client(fd, hostname), sentMessages(0), sentBytes(0) {}
+
+    virtual ~BenchClient() {}
+
+    virtual void sendMessage(const std::string &message) const {
+        ++sentMessages;
+        sentBytes += message.length();
+        benchmark::DoNotOptimize(message.data());
+    }
+};
+
+// ベンチマーク用のニックネームを生成する ("bench42" など)
+inline std::string benchNick(int index) {
+    std::ostringstream oss;
+    oss << "bench" << index;
+    return oss.str();
+}
+
+// 登録済みの BenchClient を作成してサーバーに追加する
+// (ClientはServerが所有権を持つため、Server::resetInstance() で削除される)
+inline BenchClient *addBenchClient(Server *server, int index) {
+    BenchClient *client = new BenchClient(1000 + index, "bench.host");
+    client->setAuthenticated(true);
+    client->setNickname(benchNick(index));
+    client->setUsername("user");
+    client->setRegistered(true);
+    server->addTestClient(client);
+    return client;
+}
+
+// members 人が参加済みのチャンネルを作成する
+inline Channel *addBenchChannel(Server *server, const std::string &name, int firstIndex,
+                                int members) {
+    Channel *channel = new Channel(name);
+    server->addChannel(channel);
+    for (int i = 0; i < members; ++i) {
+        BenchClient *client = addBenchClient(server, firstIndex + i);
+        channel->addMember(client);
+        client->addChannel(channel);
+    }
+    return channel;
+}
+
+// 全ベンチマークで共通のサーバーを初期化する
+inline Server *resetBenchServer() {
+    Server::resetInstance();
+    return Server::getInstance(6667, "pass123");
+}
+
+#endif
@@ -0,0 +1,7 @@
+#include <benchmark/benchmark.h>
+
+// Server.o がリンク時に参照するために g_running の実体を定義する。
+// ベンチマークでも mainLoop() は実行しない。
+volatile bool g_running = true;
+
+BENCHMARK_MAIN();
@@ -0,0 +1,18 @@
+#include "BenchFixture.hpp"
+
+// members 人のチャンネルへのブロードキャスト (送信者自身は除く)
+static void BM_ChannelBroadcast(benchmark::State &state) {
+    const int members = static_cast<int>(state.range(0));
+    Server *server = resetBenchServer();
+    Channel *channel = addBenchChannel(server, "#fanout", 0, members);
+    Client *sender = server->getClientByNickname(benchNick(0));
+    const std::string message = sender->getPrefix() +
+                                " PRIVMSG #fanout :hello from a fairly ordinary chat line\r\n";
+
+    for (auto _ : state) {
+        channel->broadcast(message, sender);
+    }
+    state.SetItemsProcessed(state.iterations() * (members - 1));
+    Server::resetInstance();
+}
+BENCHMARK(BM_ChannelBroadcast)->RangeMultiplier(4)->Range(4, 16384);
@@ -0,0 +1,42 @@
+#include "BenchFixture.hpp"
+
+// 受信バッファからの行の切り出し (1回の recv に lines 行が届いた場合)
+static void BM_ReadLineFromBuffer(benchmark::State &state) {
+    const int lines = static_cast<int>(state.range(0));
+    std::string chunk;
+    for (int i = 0; i < lines; ++i) {
+        chunk += "PRIVMSG #channel :hello from a fairly ordinary chat line\r\n";
+    }
+
+    Client client(-1, "bench.host");
+    for (auto _ : state) {
+        client.appendBuffer(chunk);
+        for (std::string line = client.readLineFromBuffer(); !line.empty();
+             line = client.readLineFromBuffer()) {
+            benchmark::DoNotOptimize(line);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * lines);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(chunk.length()));
+}
+BENCHMARK(BM_ReadLineFromBuffer)->Arg(1)->Arg(16)->Arg(256);
+
+// 送信バッファへの追加と部分送信後の削除
+static void BM_SendBufferAppendRemove(benchmark::State &state) {
+    const std::string reply = ":nick!user@bench.host PRIVMSG #channel :hello from a fairly "
+                              "ordinary chat line\r\n";
+    const int messages = static_cast<int>(state.range(0));
+
+    Client client(-1, "bench.host");
+    for (auto _ : state) {
+        for (int i = 0; i < messages; ++i) {
+            client.appendToSendBuffer(reply);
+        }
+        // 一度に送れるのは一部だけ、という状況を模す
+        while (!client.getSendBuffer().empty()) {
+            client.removeSentData(1024);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * messages);
+}
+BENCHMARK(BM_SendBufferAppendRemove)->Arg(1)->Arg(64)->Arg(1024);
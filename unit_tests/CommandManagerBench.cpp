@@ -0,0 +1,93 @@
+#include "BenchFixture.hpp"
+#include <chrono>
+
+// パースと最小限の実行 (PONG は最終アクティビティ時刻を更新するだけ)
+static void BM_ParseAndExecute_Pong(benchmark::State &state) {
+    Server *server = resetBenchServer();
+    CommandManager cmdManager(server);
+    BenchClient *client = addBenchClient(server, 0);
+    const std::string line = "PONG :irc.myserver.com";
+
+    for (auto _ : state) {
+        cmdManager.parseAndExecute(client, line);
+    }
+    state.SetItemsProcessed(state.iterations());
+    Server::resetInstance();
+}
+BENCHMARK(BM_ParseAndExecute_Pong);
+
+// ユーザー宛て PRIVMSG の解析から配送まで
+static void BM_ParseAndExecute_PrivmsgToUser(benchmark::State &state) {
+    Server *server = resetBenchServer();
+    CommandManager cmdManager(server);
+    BenchClient *sender = addBenchClient(server, 0);
+    addBenchClient(server, 1);
+    const std::string line = "PRIVMSG " + benchNick(1) + " :hello from a fairly ordinary chat line";
+
+    for (auto _ : state) {
+        cmdManager.parseAndExecute(sender, line);
+    }
+    state.SetItemsProcessed(state.iterations());
+    Server::resetInstance();
+}
+BENCHMARK(BM_ParseAndExecute_PrivmsgToUser);
+
+// members 人のチャンネルへの JOIN と PART の組 (JOIN / PART 通知の配送と NAMES の応答を含む)。
+// PauseTiming / ResumeTiming は1回で小さいチャンネルへの JOIN と同程度かかるため使わず、
+// JOIN だけのコストは BM_Part との差から求める
+static void BM_JoinPartBurst(benchmark::State &state) {
+    const int members = static_cast<int>(state.range(0));
+    Server *server = resetBenchServer();
+    CommandManager cmdManager(server);
+    addBenchChannel(server, "#burst", 1, members);
+    BenchClient *joiner = addBenchClient(server, 0);
+    const std::string join = "JOIN #burst";
+    const std::string part = "PART #burst";
+
+    for (auto _ : state) {
+        cmdManager.parseAndExecute(joiner, join);
+        cmdManager.parseAndExecute(joiner, part);
+    }
+    state.SetItemsProcessed(state.iterations());
+    Server::resetInstance();
+}
+BENCHMARK(BM_JoinPartBurst)->RangeMultiplier(8)->Range(8, 4096);
+
+// members 人のチャンネルからの PART (PART 通知の配送)。JOIN し直す時間を含めないよう手動で計測する
+static void BM_Part(benchmark::State &state) {
+    const int members = static_cast<int>(state.range(0));
+    Server *server = resetBenchServer();
+    CommandManager cmdManager(server);
+    addBenchChannel(server, "#burst", 1, members);
+    BenchClient *joiner = addBenchClient(server, 0);
+    const std::string join = "JOIN #burst";
+    const std::string part = "PART #burst";
+
+    for (auto _ : state) {
+        cmdManager.parseAndExecute(joiner, join);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        cmdManager.parseAndExecute(joiner, part);
+        state.SetIterationTime(
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    state.SetItemsProcessed(state.iterations());
+    Server::resetInstance();
+}
+BENCHMARK(BM_Part)->RangeMultiplier(8)->Range(8, 4096)->UseManualTime();
+
+// members 人のチャンネルに対する NAMES
+static void BM_Names(benchmark::State &state) {
+    const int members = static_cast<int>(state.range(0));
+    Server *server = resetBenchServer();
+    CommandManager cmdManager(server);
+    addBenchChannel(server, "#names", 0, members);
+    BenchClient *client = static_cast<BenchClient *>(server->getClientByNickname(benchNick(0)));
+    const std::string line = "NAMES #names";
+
+    for (auto _ : state) {
+        cmdManager.parseAndExecute(client, line);
+    }
+    state.SetItemsProcessed(state.iterations());
+    Server::resetInstance();
+}
+BENCHMARK(BM_Names)->RangeMultiplier(8)->Range(8, 4096);
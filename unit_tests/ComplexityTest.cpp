@@ -0,0 +1,195 @@
+#include "TestFixture.hpp"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+// 計算量の退行を検出するテスト。
+// クライアント数・チャンネル数 N を 1k -> 10k -> 100k と 10 倍ずつ増やし、
+// 1操作あたりの時間の伸び (N が 10 倍になったときの比) が期待する計算量に収まることを確かめる。
+// O(1) / O(log N) なら比はほぼ 1〜2、O(N) なら約 10、O(N^2) なら約 100 になる。
+// 時間の計測はマシンの負荷に左右されるため、ft_irc_unittest には含めず `make complexity` で実行する。
+
+static const int kSizes[] = {1000, 10000, 100000};
+static const int kSizeCount = sizeof(kSizes) / sizeof(kSizes[0]);
+
+// 比の上限。N = 100k では木構造のたどりでキャッシュミスが増え、O(log N) でも比が 4 前後になるため、
+// 線形 (約 10) と区別できる範囲で余裕を持たせる
+static const double kMaxRatioLogarithmic = 6.0; // O(1) / O(log N) を期待する操作
+static const double kMaxRatioLinear = 30.0;     // O(N) までを許容する操作
+
+// 1回の計測で実行する操作の数。操作ごとに別のクライアント・チャンネルを使うため、最小の N を超えないこと
+static const int kBatch = 1000;
+static const int kRepetitions = 7; // 計測を繰り返し、中央値を採用する
+
+static std::string indexedName(const std::string &prefix, int index) {
+    std::ostringstream oss;
+    oss << prefix << index;
+    return oss.str();
+}
+
+class ComplexityTest : public CommandManagerTest {
+  protected:
+    std::vector<TestClient *> clients;
+
+    // N 人の登録済みクライアントと、それぞれが1人で入っている N 個のチャンネルを持つサーバーを作り直す
+    void rebuild(int n) {
+        delete cmdManager;
+        Server::resetInstance();
+        server = Server::getInstance(6667, "pass123");
+
+        client1 = new TestClient(10, "probe.host");
+        server->addTestClient(client1);
+        registerClient(client1, "Probe");
+        client2 = NULL;
+
+        clients.clear();
+        clients.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            TestClient *client = new TestClient(1000 + i, "cx.host");
+            server->addTestClient(client);
+            registerClient(client, indexedName("cx", i));
+            Channel *channel = new Channel(indexedName("#cx", i));
+            server->addChannel(channel);
+            channel->addMember(client);
+            client->addChannel(channel);
+            clients.push_back(client);
+        }
+        cmdManager = new CommandManager(server);
+    }
+
+    // op(rep, i) を kBatch 回実行する計測を kRepetitions 回行い、1操作あたりの時間 (ns) の中央値を返す。
+    // prepare(rep) は計測の外で毎回呼ばれる
+    template <typename Prepare, typename Op> double nanosPerOp(Prepare prepare, Op op) {
+        std::vector<double> elapsed(kRepetitions);
+        for (int rep = 0; rep < kRepetitions; ++rep) {
+            prepare(rep);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int i = 0; i < kBatch; ++i) {
+                op(rep, i);
+            }
+            elapsed[rep] = std::chrono::duration<double, std::nano>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+        }
+        std::nth_element(elapsed.begin(), elapsed.begin() + kRepetitions / 2, elapsed.end());
+        return elapsed[kRepetitions / 2] / kBatch;
+    }
+
+    // サイズごとの計測値の比が上限を超えていないかを検証する
+    void expectGrowth(const char *operation, const double (&nanos)[kSizeCount], double maxRatio) {
+        for (int i = 1; i < kSizeCount; ++i) {
+            double ratio = nanos[i] / nanos[i - 1];
+            EXPECT_LT(ratio, maxRatio)
+                << operation << ": " << nanos[i - 1] << " ns/op at N=" << kSizes[i - 1] << " -> "
+                << nanos[i] << " ns/op at N=" << kSizes[i];
+        }
+    }
+
+    void clearProbe(int) { client1->receivedMessages.clear(); }
+};
+
+// 新しいチャンネルへの JOIN: 既存のチャンネル数 N によらないこと
+TEST_F(ComplexityTest, Join_NewChannel) {
+    double nanos[kSizeCount];
+    for (int s = 0; s < kSizeCount; ++s) {
+        rebuild(kSizes[s]);
+        // 前回の計測で入ったチャンネルから抜け、クライアントごとの参加数が繰り返しで増えないようにする
+        nanos[s] = nanosPerOp(
+            [this](int rep) {
+                for (int i = 0; rep > 0 && i < kBatch; ++i) {
+                    std::ostringstream channel;
+                    channel << "#join" << (rep - 1) << "_" << i;
+                    cmdManager->parseAndExecute(clients[i], "PART " + channel.str());
+                    clients[i]->receivedMessages.clear();
+                }
+            },
+            [this](int rep, int i) {
+                std::ostringstream channel;
+                channel << "#join" << rep << "_" << i;
+                cmdManager->parseAndExecute(clients[i], "JOIN " + channel.str());
+            });
+    }
+    expectGrowth("JOIN", nanos, kMaxRatioLogarithmic);
+}
+
+// ユーザー宛ての PRIVMSG: ニックネームの検索がクライアント数 N によらないこと
+TEST_F(ComplexityTest, Privmsg_ToUser) {
+    double nanos[kSizeCount];
+    for (int s = 0; s < kSizeCount; ++s) {
+        rebuild(kSizes[s]);
+        int n = kSizes[s];
+        // 後から追加したクライアントほど線形探索では遅くなるため、末尾側を宛先にする
+        nanos[s] = nanosPerOp(
+            [this, n](int) {
+                for (int i = 0; i < kBatch; ++i) {
+                    clients[n - 1 - i]->receivedMessages.clear();
+                }
+            },
+            [this, n](int, int i) {
+                cmdManager->parseAndExecute(client1, "PRIVMSG " + indexedName("cx", n - 1 - i) +
+                                                         " :complexity");
+            });
+    }
+    expectGrowth("PRIVMSG <nick>", nanos, kMaxRatioLogarithmic);
+}
+
+// WHO <channel>: 1人だけのチャンネルの検索と応答がチャンネル数 N によらないこと
+TEST_F(ComplexityTest, Who_SmallChannel) {
+    double nanos[kSizeCount];
+    for (int s = 0; s < kSizeCount; ++s) {
+        rebuild(kSizes[s]);
+        int n = kSizes[s];
+        nanos[s] = nanosPerOp([this](int rep) { clearProbe(rep); },
+                              [this, n](int, int i) {
+                                  cmdManager->parseAndExecute(client1,
+                                                              "WHO " + indexedName("#cx", n - 1 - i));
+                              });
+    }
+    expectGrowth("WHO <channel>", nanos, kMaxRatioLogarithmic);
+}
+
+// Channel::isMember: メンバー数 N のチャンネルでも線形探索にならないこと
+TEST_F(ComplexityTest, Channel_IsMember) {
+    double nanos[kSizeCount];
+    for (int s = 0; s < kSizeCount; ++s) {
+        rebuild(kSizes[s]);
+        int n = kSizes[s];
+        Channel *channel = new Channel("#everyone");
+        server->addChannel(channel);
+        for (int i = 0; i < n; ++i) {
+            channel->addMember(clients[i]);
+        }
+        bool found = true;
+        nanos[s] = nanosPerOp([](int) {},
+                              [this, n, channel, &found](int, int i) {
+                                  found = channel->isMember(clients[n - 1 - i]) && found;
+                              });
+        ASSERT_TRUE(found);
+    }
+    expectGrowth("Channel::isMember", nanos, kMaxRatioLogarithmic);
+}
+
+// removeClient: 切断ごとに全チャンネルを走査する実装までは許容し、O(N) を超えないこと
+TEST_F(ComplexityTest, RemoveClient) {
+    double nanos[kSizeCount];
+    for (int s = 0; s < kSizeCount; ++s) {
+        rebuild(kSizes[s]);
+        int n = kSizes[s];
+        // 計測ごとに、チャンネル #cx<i> に入っているクライアントを kBatch 人追加しておく
+        std::vector<int> fds(kBatch);
+        nanos[s] = nanosPerOp(
+            [this, n, &fds](int rep) {
+                for (int i = 0; i < kBatch; ++i) {
+                    fds[i] = 500000 + rep * kBatch + i;
+                    TestClient *client = new TestClient(fds[i], "leave.host");
+                    server->addTestClient(client);
+                    registerClient(client, indexedName("lv", fds[i]));
+                    Channel *channel = server->getChannel(indexedName("#cx", n - 1 - i));
+                    channel->addMember(client);
+                    client->addChannel(channel);
+                }
+            },
+            [this, &fds](int, int i) { server->removeClient(fds[i]); });
+    }
+    expectGrowth("removeClient", nanos, kMaxRatioLinear);
+}
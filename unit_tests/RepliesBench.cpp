@@ -0,0 +1,39 @@
+#include "BenchFixture.hpp"
+#include <vector>
+
+// 引数1つのエラー応答
+static void BM_FormatReply_NoSuchNick(benchmark::State &state) {
+    const std::string serverName = "irc.myserver.com";
+    const std::string nick = "sender";
+    std::vector<std::string> params;
+    params.push_back("nonexistent");
+
+    for (auto _ : state) {
+        std::string reply = formatReply(serverName, nick, ERR_NOSUCHNICK, params);
+        benchmark::DoNotOptimize(reply);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FormatReply_NoSuchNick);
+
+// 引数の多い応答 (WHO の1行分)
+static void BM_FormatReply_WhoReply(benchmark::State &state) {
+    const std::string serverName = "irc.myserver.com";
+    const std::string nick = "sender";
+    std::vector<std::string> params;
+    params.push_back("#channel");
+    params.push_back("user");
+    params.push_back("client.host");
+    params.push_back(serverName);
+    params.push_back("target");
+    params.push_back("H@");
+    params.push_back("0");
+    params.push_back("Real Name");
+
+    for (auto _ : state) {
+        std::string reply = formatReply(serverName, nick, RPL_WHOREPLY, params);
+        benchmark::DoNotOptimize(reply);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FormatReply_WhoReply);
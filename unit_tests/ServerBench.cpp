@@ -0,0 +1,39 @@
+#include "BenchFixture.hpp"
+
+// clients 人が接続しているサーバーでのニックネーム検索
+static void BM_GetClientByNickname(benchmark::State &state) {
+    const int clients = static_cast<int>(state.range(0));
+    Server *server = resetBenchServer();
+    for (int i = 0; i < clients; ++i) {
+        addBenchClient(server, i);
+    }
+    // 先頭・中央・末尾を順に検索する
+    const std::string nicks[3] = {benchNick(0), benchNick(clients / 2), benchNick(clients - 1)};
+
+    std::size_t n = 0;
+    for (auto _ : state) {
+        Client *client = server->getClientByNickname(nicks[n++ % 3]);
+        benchmark::DoNotOptimize(client);
+    }
+    state.SetItemsProcessed(state.iterations());
+    Server::resetInstance();
+}
+BENCHMARK(BM_GetClientByNickname)->RangeMultiplier(8)->Range(8, 32768);
+
+// 存在しないニックネームの検索 (NICK の重複チェックで毎回起きる)
+static void BM_GetClientByNickname_Miss(benchmark::State &state) {
+    const int clients = static_cast<int>(state.range(0));
+    Server *server = resetBenchServer();
+    for (int i = 0; i < clients; ++i) {
+        addBenchClient(server, i);
+    }
+    const std::string nick = "nobody_has_this_nick";
+
+    for (auto _ : state) {
+        Client *client = server->getClientByNickname(nick);
+        benchmark::DoNotOptimize(client);
+    }
+    state.SetItemsProcessed(state.iterations());
+    Server::resetInstance();
+}
+BENCHMARK(BM_GetClientByNickname_Miss)->RangeMultiplier(8)->Range(8, 32768);
@@ -19,6 +19,7 @@
 #include "Server.hpp"
 #include "UserCommand.hpp"
 #include "gtest/gtest.h"
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -231,4 +232,48 @@ template <> class DebugVector<std::string> {
     const std::vector<std::string> &m_vec;
 };
 
+/**
+ * @brief これまでの operator new の呼び出し回数を返す
+ * (main.cpp で置き換えた operator new が加算する)
+ */
+std::size_t allocationCount();
+
+/**
+ * @brief 生成時点からの operator new の呼び出し回数を数えるヘルパー
+ */
+class AllocationCounter {
+  public:
+    AllocationCounter() : _start(allocationCount()) {}
+
+    std::size_t count() const { return allocationCount() - _start; }
+
+  private:
+    std::size_t _start;
+};
+
+// 割り当て回数の上限をまだ実測していないことを表す値。
+// この値の間は検証せず、計測した回数を表示するだけにする
+static const std::size_t kAllocBudgetNotRecorded = static_cast<std::size_t>(-1);
+
+// operations 回の操作で発生した割り当てが、1回あたり budgetPerOp 回以下であることを検証する
+inline void expectAllocationsWithin(std::size_t budgetPerOp, std::size_t operations,
+                                    std::size_t allocations, const std::string &what) {
+    if (budgetPerOp == kAllocBudgetNotRecorded) {
+        std::cout << "[ ALLOCS   ] " << what << ": " << allocations << " allocations in "
+                  << operations << " ops (budget not recorded yet)" << std::endl;
+        return;
+    }
+    EXPECT_LE(allocations, budgetPerOp * operations)
+        << what << ": measured " << allocations << " allocations in " << operations << " ops";
+}
+
+// statement の実行中に発生した割り当てが limit 回以下であることを検証する
+#define EXPECT_ALLOCATIONS_AT_MOST(limit, statement)                                               \
+    do {                                                                                           \
+        AllocationCounter allocationCounter_;                                                      \
+        statement;                                                                                 \
+        expectAllocationsWithin(static_cast<std::size_t>(limit), 1, allocationCounter_.count(),   \
+                                #statement);                                                       \
+    } while (0)
+
 #endif
@@ -1,4 +1,7 @@
 #include "gtest/gtest.h"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
 
 // 個々のテストファイルはGTestのフレームワークに登録されるため、
 // ここで明示的にincludeする必要はありません。
@@ -14,6 +17,29 @@ volatile bool g_running = true;
 //     g_running = false;
 // }
 
+// 割り当て回数を数えるために operator new / delete を置き換える。
+// TestFixture.hpp の AllocationCounter / EXPECT_ALLOCATIONS_AT_MOST がこの値を参照する。
+// ユニットテストはシングルスレッドで動くため、カウンタは atomic にしない。
+static std::size_t g_allocationCount = 0;
+
+std::size_t allocationCount() { return g_allocationCount; }
+
+void *operator new(std::size_t size) {
+    ++g_allocationCount;
+    void *ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == NULL) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t size) noexcept {
+    (void)size;
+    std::free(ptr);
+}
+
 int main(int argc, char **argv) {
     // Initializes Google Test. This must be called before RUN_ALL_TESTS().
     ::testing::InitGoogleTest(&argc, argv);